@@ -0,0 +1,85 @@
+// LimitEvaluator::refineOntoLimit against uniform Catmull-Clark refinement.
+//   limitbench <file.obj> [levels] [repeats]
+// Refines the mesh levels times onto the limit surface, then checks every vert
+// against the closed-form limit position of the same vert after levels uniform
+// levels (they should agree to float precision), and against where uniform
+// refinement has moved it after 1 to 4 more levels (the gap should shrink with
+// every level). Uniform refinement keeps a vert's index from level to level, so
+// vert v of every deeper level is the same point of the surface.
+#include "core/bsplinepatch.h"
+#include "core/catmullclark.h"
+#include "core/limitevaluator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+double bestSeconds(int repeats, F&& run) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        Clock::time_point start = Clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <file.obj> [levels] [repeats]\n", argv[0]);
+        return 1;
+    }
+    const std::string filePath = argv[1];
+    const int levels = argc > 2 ? std::max(1, std::atoi(argv[2])) : 2;
+    const int repeats = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+    HalfEdgeMesh base(TwinLayout::Paired);
+    if (!base.loadOBJ(filePath)) {
+        std::fprintf(stderr, "could not load %s\n", filePath.c_str());
+        return 1;
+    }
+
+    const LimitEvaluator evaluator(base);
+    HalfEdgeMesh onLimit(TwinLayout::Paired);
+    std::vector<glm::vec3> normals;
+    double limitTime = bestSeconds(repeats, [&] { evaluator.refineOntoLimit(levels, onLimit, normals); });
+
+    HalfEdgeMesh uniform = base;
+    HalfEdgeMesh fine(TwinLayout::Paired);
+    double uniformTime = bestSeconds(repeats, [&] {
+        uniform = base;
+        for (int level = 0; level < levels; ++level) {
+            CatmullClark::subdivide(uniform, fine);
+            std::swap(uniform, fine);
+        }
+    });
+
+    std::printf("%s: %u faces, %d levels, %u verts, best of %d\n", filePath.c_str(), base.numFaces(), levels,
+                onLimit.numVertices(), repeats);
+    std::printf("%-34s %9.2f ms\n", "refineOntoLimit", limitTime * 1e3);
+    std::printf("%-34s %9.2f ms\n", "uniform refinement", uniformTime * 1e3);
+
+    auto worstDistance = [&](auto&& reference) {
+        double worst = 0.0;
+        for (MeshIndex v = 0; v < onLimit.numVertices(); ++v) {
+            worst = std::max(worst, static_cast<double>(glm::length(reference(v) - onLimit.position(v))));
+        }
+        return worst;
+    };
+    std::printf("%-34s %12.3g\n", "worst distance to limitPosition",
+                worstDistance([&](MeshIndex v) { return limitPosition(uniform, v); }));
+    for (int extra = 1; extra <= 4; ++extra) {
+        CatmullClark::subdivide(uniform, fine);
+        std::swap(uniform, fine);
+        char label[64];
+        std::snprintf(label, sizeof(label), "worst distance, uniform +%d levels", extra);
+        std::printf("%-34s %12.3g\n", label, worstDistance([&](MeshIndex v) { return uniform.position(v); }));
+    }
+    return 0;
+}
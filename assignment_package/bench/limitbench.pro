@@ -0,0 +1,36 @@
+# LimitEvaluator against deep uniform refinement, builds without Qt:
+#   qmake limitbench.pro && make && ./limitbench ../../obj_files/cow.obj 2
+TARGET = limitbench
+TEMPLATE = app
+CONFIG += console c++2a release thread
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../include ../src
+
+SOURCES += \
+    limitbench.cpp \
+    ../src/core/bsplinepatch.cpp \
+    ../src/core/catmullclark.cpp \
+    ../src/core/halfedgemesh.cpp \
+    ../src/core/hedsformat.cpp \
+    ../src/core/limitevaluator.cpp \
+    ../src/core/loopsubdivision.cpp \
+    ../src/core/mappedfile.cpp \
+    ../src/core/objparser.cpp \
+    ../src/core/radixsort.cpp \
+    ../src/core/stenciltable.cpp
+
+HEADERS += \
+    ../src/core/bsplinepatch.h \
+    ../src/core/catmullclark.h \
+    ../src/core/circulators.h \
+    ../src/core/halfedgemesh.h \
+    ../src/core/hedsformat.h \
+    ../src/core/limitevaluator.h \
+    ../src/core/loadprogress.h \
+    ../src/core/loopsubdivision.h \
+    ../src/core/mappedfile.h \
+    ../src/core/objparser.h \
+    ../src/core/parallel.h \
+    ../src/core/radixsort.h \
+    ../src/core/stenciltable.h
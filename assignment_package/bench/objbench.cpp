@@ -0,0 +1,108 @@
+// OBJ loading throughput in MB/s.
+//   objbench <file.obj> [repeats]
+// Times the old getline/istringstream tokenizer against parseOBJ on the mapped
+// file (on one thread and on every core), then the whole HalfEdgeMesh::loadOBJ
+// (parse + half-edge build) and loading the same mesh back from a .heds cache.
+#include "core/halfedgemesh.h"
+#include "core/mappedfile.h"
+#include "core/objparser.h"
+#include "core/parallel.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+//the loader this repo used before parseOBJ, kept as the baseline
+bool parseWithStreams(const std::string& filePath, ObjPolygons& out) {
+    out.clear();
+    std::ifstream objFile(filePath);
+    if (!objFile.is_open()) return false;
+
+    std::string line;
+    while (std::getline(objFile, line)) {
+        std::istringstream iss(line);
+        std::string prefix;
+        iss >> prefix;
+
+        if (prefix == "v") {
+            float x, y, z;
+            iss >> x >> y >> z;
+            out.positions.push_back(glm::vec3(x, y, z));
+        } else if (prefix == "f") {
+            std::string triplet;
+            while (iss >> triplet) {
+                std::istringstream tripletStream(triplet);
+                std::string posIndexStr;
+                std::getline(tripletStream, posIndexStr, '/');
+                out.cornerVerts.push_back(std::stoi(posIndexStr) - 1);
+            }
+            out.faceOffsets.push_back(static_cast<MeshIndex>(out.cornerVerts.size()));
+        }
+    }
+    return true;
+}
+
+template <typename F>
+double bestSeconds(int repeats, F&& run) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        Clock::time_point start = Clock::now();
+        if (!run()) {
+            std::fprintf(stderr, "run failed\n");
+            std::exit(1);
+        }
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+void report(const char* name, double bytes, double seconds) {
+    std::printf("%-28s %9.2f ms  %9.1f MB/s\n", name, seconds * 1e3, bytes / (1024.0 * 1024.0) / seconds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <file.obj> [repeats]\n", argv[0]);
+        return 1;
+    }
+    const std::string filePath = argv[1];
+    const int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    MappedFile file;
+    if (!file.open(filePath)) {
+        std::fprintf(stderr, "could not open %s\n", filePath.c_str());
+        return 1;
+    }
+    const double bytes = static_cast<double>(file.size());
+
+    ObjPolygons polygons;
+    std::string error;
+    double streams = bestSeconds(repeats, [&] { return parseWithStreams(filePath, polygons); });
+    double mapped = bestSeconds(repeats, [&] {
+        return parseOBJ(file.data(), file.data() + file.size(), polygons, error, 1);
+    });
+    double threaded = bestSeconds(repeats, [&] {
+        return parseOBJ(file.data(), file.data() + file.size(), polygons, error);
+    });
+    HalfEdgeMesh mesh(TwinLayout::Paired);
+    double load = bestSeconds(repeats, [&] { return mesh.loadOBJ(filePath); });
+    const std::string hedsPath = filePath + ".heds";
+    if (!mesh.saveHEDS(hedsPath)) return 1;
+    double heds = bestSeconds(repeats, [&] { return mesh.loadHEDS(hedsPath); });
+
+    std::printf("%s: %.2f MB, %zu verts, %u faces, best of %d, %u threads\n", filePath.c_str(),
+                bytes / (1024.0 * 1024.0), polygons.positions.size(), polygons.numFaces(), repeats, workerCount());
+    report("getline + istringstream", bytes, streams);
+    report("mmap + from_chars", bytes, mapped);
+    report("mmap + from_chars, threaded", bytes, threaded);
+    report("loadOBJ (parse + build)", bytes, load);
+    report("loadHEDS (same mesh)", bytes, heds);
+    return 0;
+}
@@ -0,0 +1,32 @@
+# OBJ loading throughput benchmark, builds without Qt:
+#   qmake objbench.pro && make && ./objbench ../../obj_files/cow.obj 20
+TARGET = objbench
+TEMPLATE = app
+CONFIG += console c++2a release thread
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../include ../src
+
+SOURCES += \
+    objbench.cpp \
+    ../src/core/catmullclark.cpp \
+    ../src/core/halfedgemesh.cpp \
+    ../src/core/hedsformat.cpp \
+    ../src/core/loopsubdivision.cpp \
+    ../src/core/mappedfile.cpp \
+    ../src/core/objparser.cpp \
+    ../src/core/radixsort.cpp \
+    ../src/core/stenciltable.cpp
+
+HEADERS += \
+    ../src/core/catmullclark.h \
+    ../src/core/circulators.h \
+    ../src/core/halfedgemesh.h \
+    ../src/core/hedsformat.h \
+    ../src/core/loadprogress.h \
+    ../src/core/loopsubdivision.h \
+    ../src/core/mappedfile.h \
+    ../src/core/objparser.h \
+    ../src/core/parallel.h \
+    ../src/core/radixsort.h \
+    ../src/core/stenciltable.h
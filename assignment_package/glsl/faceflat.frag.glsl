@@ -0,0 +1,16 @@
+#version 330 core
+
+// Flat colors for meshes drawn from shared vertices. gl_PrimitiveID numbers the
+// triangles of the draw call, u_TriangleFaces maps each to the face it was
+// fanned from and u_FaceColors holds every face's color.
+
+uniform samplerBuffer u_FaceColors;
+uniform usamplerBuffer u_TriangleFaces;
+
+out vec3 out_Col;
+
+void main()
+{
+    uint face = texelFetch(u_TriangleFaces, gl_PrimitiveID).r;
+    out_Col = texelFetch(u_FaceColors, int(face)).rgb;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+
+// Like flat.vert.glsl, but positions are shared between the faces around a
+// vertex, so the color can't come in as an attribute; faceflat.frag.glsl
+// looks it up per face instead.
+
+uniform mat4 u_Model;
+uniform mat4 u_ViewProj;
+
+in vec3 vs_Pos;
+
+void main()
+{
+    vec4 modelposition = u_Model * vec4(vs_Pos, 1.);
+
+    //built-in things to pass down the pipeline
+    gl_Position = u_ViewProj * modelposition;
+
+}
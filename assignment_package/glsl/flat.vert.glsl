@@ -4,6 +4,7 @@
 
 uniform mat4 u_Model;
 uniform mat4 u_ViewProj;
+uniform mat4 u_Dequantize; // takes quantized positions back to model space, else the identity
 
 in vec3 vs_Pos;
 in vec3 vs_Col;
@@ -13,7 +14,7 @@ out vec3 fs_Col;
 void main()
 {
     fs_Col = vs_Col;
-    vec4 modelposition = u_Model * vec4(vs_Pos, 1.);
+    vec4 modelposition = u_Model * u_Dequantize * vec4(vs_Pos, 1.);
 
     //built-in things to pass down the pipeline
     gl_Position = u_ViewProj * modelposition;
@@ -19,29 +19,46 @@ uniform mat4 u_ViewProj;    // The matrix that defines the camera's transformati
                             // We've written a static matrix for you to use for HW2,
                             // but in HW3 you'll have to generate one yourself
 
+uniform mat4 u_Dequantize;  // Takes quantized positions back to model space, else the identity
+
+uniform bool u_OctNormals;  // Whether the normals come in vs_OctNor rather than vs_Nor
+
 in vec3 vs_Pos;             // The array of vertex positions passed to the shader
 
 in vec3 vs_Nor;             // The array of vertex normals passed to the shader
 
+in vec2 vs_OctNor;          // Or the normals folded onto the octahedron, as packed vertex formats store them
+
 in vec3 vs_Col;             // The array of vertex colors passed to the shader.
 
 out vec3 fs_Pos;
 out vec3 fs_Nor;            // The array of normals that has been transformed by u_ModelInvTr. This is implicitly passed to the fragment shader.
 out vec3 fs_Col;            // The color of each vertex. This is implicitly passed to the fragment shader.
 
+// Unfolds a normal stored on the octahedron |x| + |y| + |z| = 1, whose lower half
+// was folded out over the corners of the square
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
 void main()
 {
     fs_Col = vs_Col;                         // Pass the vertex colors to the fragment shader for interpolation
 
     mat3 invTranspose = mat3(u_ModelInvTr);
-    fs_Nor = invTranspose * vs_Nor;          // Pass the vertex normals to the fragment shader for interpolation.
+    fs_Nor = invTranspose * (u_OctNormals ? octDecode(vs_OctNor) : vs_Nor);          // Pass the vertex normals to the fragment shader for interpolation.
                                                             // Transform the geometry's normals by the inverse transpose of the
                                                             // model matrix. This is necessary to ensure the normals remain
                                                             // perpendicular to the surface after the surface is transformed by
                                                             // the model matrix.
 
 
-    vec4 modelposition = u_Model * vec4(vs_Pos, 1.);   // Temporarily store the transformed vertex positions for use below
+    vec4 modelposition = u_Model * u_Dequantize * vec4(vs_Pos, 1.);   // Temporarily store the transformed vertex positions for use below
     fs_Pos = modelposition.xyz;
 
     gl_Position = u_ViewProj * modelposition;// gl_Position is a built-in variable of OpenGL which is
@@ -1,4 +1,4 @@
-QT += core widgets openglwidgets
+QT += core widgets openglwidgets concurrent
 
 TARGET = MicroMaya
 TEMPLATE = app
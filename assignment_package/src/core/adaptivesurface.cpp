@@ -0,0 +1,203 @@
+#include "adaptivesurface.h"
+#include "bsplinepatch.h"
+#include "catmullclark.h"
+#include "circulators.h"
+#include "objparser.h"
+#include "parallel.h"
+
+namespace {
+
+//add every face that shares a vert with a face already in the region
+void growByVertexRing(const HalfEdgeMesh& mesh, std::vector<uint8_t>& inRegion) {
+    std::vector<uint8_t> touched(mesh.numVertices(), 0);
+    for (MeshIndex f = 0; f < mesh.numFaces(); ++f) {
+        if (!inRegion[f]) continue;
+        for (MeshIndex v : faceVertices(mesh, f)) {
+            touched[v] = 1;
+        }
+    }
+    for (MeshIndex f = 0; f < mesh.numFaces(); ++f) {
+        const FaceVertices corners = faceVertices(mesh, f);
+        if (std::any_of(corners.begin(), corners.end(), [&](MeshIndex v) { return touched[v]; })) inRegion[f] = 1;
+    }
+}
+
+} // namespace
+
+void AdaptiveSurface::clear() {
+    maxDepth = 0;
+    points.clear();
+    patchPoints.clear();
+    patchLevels.clear();
+    patchColors.clear();
+    quadPoints.clear();
+    quadColors.clear();
+}
+
+std::size_t AdaptiveSurface::memoryBytes() const {
+    return points.size() * sizeof(glm::vec3) + patchPoints.size() * sizeof(MeshIndex) +
+           patchLevels.size() * sizeof(uint8_t) + patchColors.size() * sizeof(glm::vec3) +
+           quadPoints.size() * sizeof(MeshIndex) + quadColors.size() * sizeof(glm::vec3);
+}
+
+void AdaptiveSurface::build(const HalfEdgeMesh& base, int depth) {
+    clear();
+    maxDepth = std::max(depth, 1);
+
+    HalfEdgeMesh refinedLevels[2]; //the level refined last, alternating so it's never the one read
+    const HalfEdgeMesh* mesh = &base;
+    std::vector<uint8_t> candidate(base.numFaces(), 1); //base faces, then children of refined faces
+
+    for (int level = 0; ; ++level) {
+        // a vert becomes a point the first time a patch (as a control point) or a
+        // depth-level quad (on the limit surface) uses it
+        std::vector<MeshIndex> controlIds(mesh->numVertices(), NO_INDEX);
+        std::vector<MeshIndex> limitIds(mesh->numVertices(), NO_INDEX);
+        auto pointId = [&](std::vector<MeshIndex>& ids, MeshIndex v, bool onLimit) {
+            if (ids[v] == NO_INDEX) {
+                ids[v] = static_cast<MeshIndex>(points.size());
+                points.push_back(onLimit ? limitPosition(*mesh, v) : mesh->position(v));
+            }
+            return ids[v];
+        };
+
+        const std::vector<uint8_t> pinched = findPinchedVerts(*mesh);
+        std::vector<uint8_t> refined(mesh->numFaces(), 0);
+        bool anyRefined = false;
+        MeshIndex grid[16];
+        for (MeshIndex f = 0; f < mesh->numFaces(); ++f) {
+            if (!candidate[f]) continue;
+            if (gatherRegularPatch(*mesh, pinched, f, grid)) {
+                for (MeshIndex v : grid) {
+                    patchPoints.push_back(pointId(controlIds, v, false));
+                }
+                patchLevels.push_back(static_cast<uint8_t>(level));
+                patchColors.push_back(mesh->faceColor(f));
+            } else if (level == maxDepth) {
+                // below the base every face is a quad
+                for (MeshIndex v : faceVertices(*mesh, f)) {
+                    quadPoints.push_back(pointId(limitIds, v, true));
+                }
+                quadColors.push_back(mesh->faceColor(f));
+            } else {
+                refined[f] = 1;
+                anyRefined = true;
+            }
+        }
+        if (!anyRefined) break;
+
+        // cut the refined faces and two rings around them out into a submesh
+        std::vector<uint8_t> inRegion = refined;
+        growByVertexRing(*mesh, inRegion);
+        growByVertexRing(*mesh, inRegion);
+
+        ObjPolygons region;
+        std::vector<MeshIndex> regionVerts(mesh->numVertices(), NO_INDEX);
+        std::vector<uint8_t> regionRefined;
+        std::vector<glm::vec3> regionColors;
+        for (MeshIndex f = 0; f < mesh->numFaces(); ++f) {
+            if (!inRegion[f]) continue;
+            for (MeshIndex corner : faceVertices(*mesh, f)) {
+                MeshIndex& v = regionVerts[corner];
+                if (v == NO_INDEX) {
+                    v = static_cast<MeshIndex>(region.positions.size());
+                    region.positions.push_back(mesh->position(corner));
+                }
+                region.cornerVerts.push_back(v);
+            }
+            region.faceOffsets.push_back(static_cast<MeshIndex>(region.cornerVerts.size()));
+            regionRefined.push_back(refined[f]);
+            regionColors.push_back(mesh->faceColor(f));
+        }
+
+        HalfEdgeMesh submesh(TwinLayout::Paired);
+        submesh.buildFromPolygons(region);
+        for (MeshIndex f = 0; f < submesh.numFaces(); ++f) {
+            submesh.setFaceColor(f, regionColors[f]);
+        }
+        HalfEdgeMesh& fine = refinedLevels[level % 2];
+        CatmullClark::subdivide(submesh, fine);
+
+        // a face's child quads are numbered consecutively, one per side, in face order
+        candidate.assign(fine.numFaces(), 0);
+        MeshIndex quad = 0;
+        for (MeshIndex f = 0; f < submesh.numFaces(); ++f) {
+            const MeshIndex numSides = static_cast<MeshIndex>(submesh.countEdgesInFace(f));
+            if (regionRefined[f]) {
+                std::fill(candidate.begin() + quad, candidate.begin() + quad + numSides, 1);
+            }
+            quad += numSides;
+        }
+        mesh = &fine;
+    }
+}
+
+void AdaptiveSurface::tessellate(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals,
+                                 std::vector<glm::vec3>& colors, std::vector<unsigned int>& indices) const {
+    // where every patch's grid verts and triangles start, then every patch fills its own range
+    const MeshIndex numPatchesTotal = numPatches();
+    std::vector<std::size_t> vertStart(numPatchesTotal + 1, 0);
+    std::vector<std::size_t> indexStart(numPatchesTotal + 1, 0);
+    for (MeshIndex p = 0; p < numPatchesTotal; ++p) {
+        const std::size_t rate = std::size_t(1) << (maxDepth - patchLevels[p]);
+        vertStart[p + 1] = vertStart[p] + (rate + 1) * (rate + 1);
+        indexStart[p + 1] = indexStart[p] + 6 * rate * rate;
+    }
+    const std::size_t quadVertStart = vertStart.back();
+    const std::size_t quadIndexStart = indexStart.back();
+    positions.resize(quadVertStart + quadPoints.size());
+    normals.resize(positions.size());
+    colors.resize(positions.size());
+    indices.resize(quadIndexStart + 6 * numQuads());
+
+    parallelFor(0, numPatchesTotal, 64, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t p = begin; p < end; ++p) {
+            glm::vec3 controlPoints[16];
+            for (int k = 0; k < 16; ++k) {
+                controlPoints[k] = points[patchPoints[16 * p + k]];
+            }
+            const unsigned rate = 1u << (maxDepth - patchLevels[p]);
+            std::size_t out = vertStart[p];
+            for (unsigned j = 0; j <= rate; ++j) {
+                for (unsigned i = 0; i <= rate; ++i, ++out) {
+                    const PatchSample sample = evaluatePatch(controlPoints, static_cast<float>(i) / rate,
+                                                             static_cast<float>(j) / rate);
+                    positions[out] = sample.position;
+                    normals[out] = glm::normalize(glm::cross(sample.tangentU, sample.tangentV));
+                    colors[out] = patchColors[p];
+                }
+            }
+
+            std::size_t index = indexStart[p];
+            const unsigned first = static_cast<unsigned>(vertStart[p]);
+            for (unsigned j = 0; j < rate; ++j) {
+                for (unsigned i = 0; i < rate; ++i) {
+                    const unsigned corner = first + j * (rate + 1) + i;
+                    indices[index++] = corner;
+                    indices[index++] = corner + 1;
+                    indices[index++] = corner + rate + 2;
+                    indices[index++] = corner;
+                    indices[index++] = corner + rate + 2;
+                    indices[index++] = corner + rate + 1;
+                }
+            }
+        }
+    });
+
+    // depth-level quads are drawn flat, as two triangles
+    for (MeshIndex q = 0; q < numQuads(); ++q) {
+        const std::size_t out = quadVertStart + 4 * q;
+        const glm::vec3& p0 = points[quadPoints[4 * q]];
+        const glm::vec3 normal = glm::normalize(glm::cross(points[quadPoints[4 * q + 1]] - p0,
+                                                           points[quadPoints[4 * q + 2]] - p0));
+        for (int k = 0; k < 4; ++k) {
+            positions[out + k] = points[quadPoints[4 * q + k]];
+            normals[out + k] = normal;
+            colors[out + k] = quadColors[q];
+        }
+        const unsigned first = static_cast<unsigned>(out);
+        const std::size_t index = quadIndexStart + 6 * q;
+        const unsigned triangles[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+        std::copy(triangles, triangles + 6, indices.begin() + index);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef ADAPTIVESURFACE_H
+#define ADAPTIVESURFACE_H
+
+#include "halfedgemesh.h"
+#include <vector>
+
+// Feature-adaptive Catmull-Clark limit surface of a base mesh. A quad whose four
+// corners are interior valence-4 verts surrounded by quads is exactly a bicubic
+// B-spline patch over its 4x4 ring of verts, so it's kept as a patch and never
+// refined. Only the faces that aren't (next to extraordinary verts, non-quads
+// and boundaries) are refined, each level re-checking just their children:
+//
+//   level l: a candidate face is a patch if it's regular, otherwise it's refined
+//            (or, at the requested depth, kept as a quad with limit positions)
+//   refine:  the refined faces plus two rings of faces around them are cut out
+//            into a submesh and subdivided; two rings keep every vert that the
+//            refined faces' children and their own ring use exact
+//
+// A patch found at level l is tessellated on a 2^(depth - l) grid, so patches of
+// any level and the depth-level quads meet at the same points, without cracks.
+class AdaptiveSurface {
+public:
+    void build(const HalfEdgeMesh& base, int depth); //depth >= 1
+    void clear();
+
+    int depth() const { return maxDepth; }
+    MeshIndex numPatches() const { return static_cast<MeshIndex>(patchLevels.size()); }
+    MeshIndex numQuads() const { return static_cast<MeshIndex>(quadColors.size()); }
+    std::size_t memoryBytes() const;
+
+    //triangles of every patch and quad, with per-corner normals and colors
+    void tessellate(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals,
+                    std::vector<glm::vec3>& colors, std::vector<unsigned int>& indices) const;
+
+private:
+    int maxDepth = 0;
+    std::vector<glm::vec3> points; //control points of the patches and corners of the quads
+
+    std::vector<MeshIndex> patchPoints; //16 per patch, row-major 4x4 control grid
+    std::vector<uint8_t> patchLevels;
+    std::vector<glm::vec3> patchColors;
+
+    std::vector<MeshIndex> quadPoints; //4 per depth-level quad, on the limit surface
+    std::vector<glm::vec3> quadColors;
+};
+
+#endif // ADAPTIVESURFACE_H
@@ -0,0 +1,109 @@
+#include "bsplinepatch.h"
+#include "circulators.h"
+
+namespace {
+
+//uniform cubic B-spline basis and its derivative at t
+void bsplineBasis(float t, float b[4], float d[4]) {
+    const float s = 1.0f - t;
+    b[0] = s * s * s / 6.0f;
+    b[1] = (3.0f * t * t * t - 6.0f * t * t + 4.0f) / 6.0f;
+    b[2] = (-3.0f * t * t * t + 3.0f * t * t + 3.0f * t + 1.0f) / 6.0f;
+    b[3] = t * t * t / 6.0f;
+    d[0] = -s * s / 2.0f;
+    d[1] = (3.0f * t * t - 4.0f * t) / 2.0f;
+    d[2] = (-3.0f * t * t + 2.0f * t + 1.0f) / 2.0f;
+    d[3] = t * t / 2.0f;
+}
+
+} // namespace
+
+bool gatherRegularPatch(const HalfEdgeMesh& mesh, const std::vector<uint8_t>& pinched, MeshIndex f,
+                        MeshIndex grid[16]) {
+    MeshIndex e[4];
+    e[0] = mesh.faceEdge(f);
+    for (int k = 1; k < 4; ++k) {
+        e[k] = mesh.next(e[k - 1]);
+    }
+    if (mesh.next(e[3]) != e[0]) return false;
+
+    // every corner is an interior valence-4 vert with only quads around it
+    for (MeshIndex corner : e) {
+        int valence = 0;
+        for (MeshIndex he : VertexHalfEdges(mesh, corner)) {
+            if (mesh.isBoundary(he) || mesh.countEdgesInFace(mesh.face(he)) != 4 || ++valence > 4) return false;
+        }
+        if (valence != 4) return false;
+    }
+
+    // the neighbour across e[k] holds the two points beyond that side, and the
+    // quad diagonal to its first vert holds the grid corner
+    const int side[4][3] = {{1, 2, 0}, {7, 11, 3}, {14, 13, 15}, {8, 4, 12}}; //near, far, corner
+    for (int k = 0; k < 4; ++k) {
+        const MeshIndex across = mesh.next(mesh.sym(e[k]));
+        grid[side[k][0]] = mesh.vert(across);
+        grid[side[k][1]] = mesh.vert(mesh.next(across));
+        grid[side[k][2]] = mesh.vert(mesh.next(mesh.next(mesh.sym(across))));
+    }
+    grid[5] = mesh.vert(e[3]);
+    grid[6] = mesh.vert(e[0]);
+    grid[10] = mesh.vert(e[1]);
+    grid[9] = mesh.vert(e[2]);
+
+    // a pinched vert is refined from just one of its fans, so it's no control point
+    for (int k = 0; k < 16; ++k) {
+        if (pinched[grid[k]]) return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> findPinchedVerts(const HalfEdgeMesh& mesh) {
+    std::vector<int> incoming(mesh.numVertices(), 0);
+    for (MeshIndex he = 0; he < mesh.numHalfEdges(); ++he) {
+        ++incoming[mesh.vert(he)];
+    }
+    std::vector<uint8_t> pinched(mesh.numVertices(), 0);
+    for (MeshIndex v = 0; v < mesh.numVertices(); ++v) {
+        const VertexHalfEdges fan = vertexHalfEdges(mesh, v);
+        if (fan.empty()) continue;
+        pinched[v] = std::distance(fan.begin(), fan.end()) != incoming[v];
+    }
+    return pinched;
+}
+
+glm::vec3 limitPosition(const HalfEdgeMesh& mesh, MeshIndex v) {
+    const VertexHalfEdges fan = vertexHalfEdges(mesh, v);
+    if (fan.empty()) return mesh.position(v);
+
+    float n = 0;
+    glm::vec3 sumNeighbours(0.0f);
+    glm::vec3 sumDiagonals(0.0f);
+    for (MeshIndex he : fan) {
+        if (mesh.isBoundary(he)) {
+            return (mesh.position(mesh.vert(mesh.sym(he))) + 4.0f * mesh.position(v) +
+                    mesh.position(mesh.vert(mesh.next(he)))) / 6.0f;
+        }
+        sumNeighbours += mesh.position(mesh.vert(mesh.sym(he)));
+        sumDiagonals += mesh.position(mesh.vert(mesh.next(mesh.next(he))));
+        n += 1.0f;
+    }
+
+    return (n * n * mesh.position(v) + 4.0f * sumNeighbours + sumDiagonals) / (n * (n + 5.0f));
+}
+
+PatchSample evaluatePatch(const glm::vec3 controlPoints[16], float u, float v) {
+    float bu[4], du[4], bv[4], dv[4];
+    bsplineBasis(u, bu, du);
+    bsplineBasis(v, bv, dv);
+
+    PatchSample sample{glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f)};
+    for (int j = 0; j < 4; ++j) {
+        for (int i = 0; i < 4; ++i) {
+            const glm::vec3& point = controlPoints[4 * j + i];
+            sample.position += bu[i] * bv[j] * point;
+            sample.tangentU += du[i] * bv[j] * point;
+            sample.tangentV += bu[i] * dv[j] * point;
+        }
+    }
+    return sample;
+}
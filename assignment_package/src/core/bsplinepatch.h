@@ -0,0 +1,40 @@
+#ifndef BSPLINEPATCH_H
+#define BSPLINEPATCH_H
+
+#include "halfedgemesh.h"
+#include <cstdint>
+#include <vector>
+
+// The parts of the Catmull-Clark limit surface that have a closed form. A quad
+// whose four corners are interior valence-4 verts with only quads around them
+// is exactly a uniform bicubic B-spline patch over its 4x4 ring of verts, and a
+// vert with only quads around it has a closed-form limit position. Everywhere
+// else the limit is only reached by refining further.
+
+//a point on a patch and its derivatives along the patch's u and v
+struct PatchSample {
+    glm::vec3 position;
+    glm::vec3 tangentU;
+    glm::vec3 tangentV;
+};
+
+//verts with more than one fan of faces around them (the fan walked from
+//vertexEdge misses some of the HEs pointing at them)
+std::vector<uint8_t> findPinchedVerts(const HalfEdgeMesh& mesh);
+
+//the 4x4 control grid of a regular quad, row-major (grid[4j + i] is point (i, j)).
+//u runs along the face's first HE: its tail a, then b, c, d sit at (1, 1), (2, 1),
+//(2, 2), (1, 2), so the patch's (0, 0) is a and (1, 0) is b. Returns false when f
+//isn't regular, including when any of its control points is pinched
+bool gatherRegularPatch(const HalfEdgeMesh& mesh, const std::vector<uint8_t>& pinched, MeshIndex f,
+                        MeshIndex grid[16]);
+
+//the patch over controlPoints (ordered like gatherRegularPatch's grid) at (u, v) in [0, 1]^2
+PatchSample evaluatePatch(const glm::vec3 controlPoints[16], float u, float v);
+
+//where v ends up after infinitely many levels, only valid when every face around
+//v is a quad: (n^2 v + 4 sum(neighbours) + sum(diagonals)) / (n (n + 5)), or the
+//cubic B-spline rule (a + 4v + b) / 6 along a boundary
+glm::vec3 limitPosition(const HalfEdgeMesh& mesh, MeshIndex v);
+
+#endif // BSPLINEPATCH_H
@@ -0,0 +1,332 @@
+#include "catmullclark.h"
+#include "circulators.h"
+#include "parallel.h"
+
+namespace {
+
+const std::size_t grain = 1 << 12;
+
+} // namespace
+
+//dense ids for the coarse mesh's edges and child quads, which every fine index is built from
+struct CatmullClark::Numbering {
+    const HalfEdgeMesh& mesh;
+    MeshIndex numVerts;
+    MeshIndex numFaces;
+    MeshIndex numEdges = 0;
+    std::vector<MeshIndex> faceStart; //first child quad of every face, numFaces + 1 entries
+    std::vector<MeshIndex> edgeIds; //dense edge id per HE, only needed in the Explicit layout
+
+    explicit Numbering(const HalfEdgeMesh& mesh);
+
+    MeshIndex edge(MeshIndex he) const { return edgeIds.empty() ? mesh.edge(he) : edgeIds[he]; }
+    bool side(MeshIndex he) const { return edgeIds.empty() ? (he & 1u) != 0 : he > mesh.sym(he); }
+
+    MeshIndex edgePoint(MeshIndex he) const { return numVerts + numFaces + edge(he); }
+    MeshIndex facePoint(MeshIndex f) const { return numVerts + f; }
+
+    MeshIndex halfA(MeshIndex he) const { return 4 * edge(he) + (side(he) ? 3 : 0); } //tail -> edge point
+    MeshIndex halfB(MeshIndex he) const { return 4 * edge(he) + (side(he) ? 1 : 2); } //edge point -> head
+    MeshIndex spokeIn(MeshIndex quad) const { return 4 * numEdges + 2 * quad; } //edge point -> face point
+    MeshIndex spokeOut(MeshIndex quad) const { return 4 * numEdges + 2 * quad + 1; } //face point -> edge point
+};
+
+CatmullClark::Numbering::Numbering(const HalfEdgeMesh& mesh)
+    : mesh(mesh), numVerts(mesh.numVertices()), numFaces(mesh.numFaces()) {
+    if (mesh.twinLayout() == TwinLayout::Paired) {
+        numEdges = mesh.numHalfEdges() / 2;
+    } else {
+        edgeIds.resize(mesh.numHalfEdges());
+        for (MeshIndex he = 0; he < mesh.numHalfEdges(); ++he) {
+            if (he < mesh.sym(he)) {
+                edgeIds[he] = numEdges;
+                edgeIds[mesh.sym(he)] = numEdges;
+                ++numEdges;
+            }
+        }
+    }
+
+    faceStart.resize(numFaces + 1);
+    faceStart[0] = 0;
+    parallelFor(0, numFaces, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex f = static_cast<MeshIndex>(begin); f < end; ++f) {
+            faceStart[f + 1] = static_cast<MeshIndex>(mesh.countEdgesInFace(f));
+        }
+    });
+    for (MeshIndex f = 0; f < numFaces; ++f) {
+        faceStart[f + 1] += faceStart[f];
+    }
+}
+
+MeshSizes CatmullClark::refinedSizes(const HalfEdgeMesh& coarse) {
+    const unsigned numRanges = static_cast<unsigned>(std::max<std::size_t>(1,
+        std::min<std::size_t>(workerCount(), coarse.numHalfEdges() / grain)));
+    std::vector<MeshIndex> rangeCorners(numRanges, 0);
+    parallelTasks(numRanges, [&](unsigned r) {
+        std::size_t begin = std::size_t(coarse.numHalfEdges()) * r / numRanges;
+        std::size_t end = std::size_t(coarse.numHalfEdges()) * (r + 1) / numRanges;
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            if (!coarse.isBoundary(he)) ++rangeCorners[r];
+        }
+    });
+    MeshIndex numQuads = 0;
+    for (MeshIndex corners : rangeCorners) numQuads += corners;
+
+    const MeshIndex numEdges = coarse.numHalfEdges() / 2;
+    return {coarse.numVertices() + coarse.numFaces() + numEdges, numQuads, 4 * numEdges + 2 * numQuads};
+}
+
+void CatmullClark::subdivide(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine) {
+    Numbering numbering(coarse);
+    refineTopology(coarse, numbering, fine);
+    refinePositions(coarse, numbering, fine);
+    if (coarse.twinLayout() == TwinLayout::Explicit) {
+        fine.setTwinLayout(TwinLayout::Explicit);
+    }
+}
+
+StencilTable CatmullClark::subdivideWithStencils(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine) {
+    Numbering numbering(coarse);
+    refineTopology(coarse, numbering, fine);
+    StencilTable stencils = refineStencils(coarse, numbering);
+    stencils.apply(coarse.positionData(), fine.positionData());
+    if (coarse.twinLayout() == TwinLayout::Explicit) {
+        fine.setTwinLayout(TwinLayout::Explicit);
+    }
+    return stencils;
+}
+
+//size the fine arrays exactly from the numbering and fill in next/face/vert for
+//every fine HE. Each coarse face writes only its own quads and the halves of its
+//own HEs, so faces run in parallel
+void CatmullClark::refineTopology(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine) {
+    const MeshSizes sizes = refinedSizes(coarse);
+
+    fine.clear();
+    fine.layout = TwinLayout::Paired;
+    fine.positions.resize(sizes.numVertices);
+    fine.vertEdges.assign(sizes.numVertices, NO_INDEX);
+    fine.faceEdges.resize(sizes.numFaces);
+    fine.faceColors.resize(sizes.numFaces);
+    fine.heNext.resize(sizes.numHalfEdges);
+    fine.heFace.resize(sizes.numHalfEdges);
+    fine.heVert.resize(sizes.numHalfEdges);
+
+    // quad j of a face sits around the head of its j-th HE:
+    // halfB(h_j) -> halfA(h_j+1) -> spokeIn(q_j+1) -> spokeOut(q_j)
+    parallelFor(0, numbering.numFaces, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex f = static_cast<MeshIndex>(begin); f < end; ++f) {
+            const MeshIndex firstQuad = numbering.faceStart[f];
+            const MeshIndex numSides = numbering.faceStart[f + 1] - firstQuad;
+            MeshIndex he = coarse.faceEdge(f);
+            for (MeshIndex j = 0; j < numSides; ++j) {
+                const MeshIndex nextHE = coarse.next(he);
+                const MeshIndex quad = firstQuad + j;
+                const MeshIndex nextQuad = firstQuad + (j + 1) % numSides;
+                const MeshIndex b = numbering.halfB(he);
+                const MeshIndex a = numbering.halfA(nextHE);
+                const MeshIndex in = numbering.spokeIn(nextQuad);
+                const MeshIndex out = numbering.spokeOut(quad);
+
+                fine.heNext[b] = a;
+                fine.heNext[a] = in;
+                fine.heNext[in] = out;
+                fine.heNext[out] = b;
+                fine.heVert[b] = coarse.vert(he);
+                fine.heVert[a] = numbering.edgePoint(nextHE);
+                fine.heVert[in] = numbering.facePoint(f);
+                fine.heVert[out] = numbering.edgePoint(he);
+                fine.heFace[b] = quad;
+                fine.heFace[a] = quad;
+                fine.heFace[in] = quad;
+                fine.heFace[out] = quad;
+
+                fine.faceEdges[quad] = b; //start on the HE that points to an original vertex
+                fine.faceColors[quad] = j == numSides - 1 ? coarse.faceColor(f) : HalfEdgeMesh::randomColor();
+
+                // exactly one interior HE of every edge claims its edge point
+                if (!numbering.side(nextHE) || coarse.isBoundary(coarse.sym(nextHE))) {
+                    fine.vertEdges[numbering.edgePoint(nextHE)] = a;
+                }
+                he = nextHE;
+            }
+            fine.vertEdges[numbering.facePoint(f)] = numbering.spokeIn(firstQuad);
+        }
+    });
+
+    // boundary HEs just split in two and keep following their loop
+    parallelFor(0, coarse.numHalfEdges(), grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            if (!coarse.isBoundary(he)) continue;
+            const MeshIndex a = numbering.halfA(he);
+            const MeshIndex b = numbering.halfB(he);
+            fine.heNext[a] = b;
+            fine.heNext[b] = numbering.halfA(coarse.next(he));
+            fine.heVert[a] = numbering.edgePoint(he);
+            fine.heVert[b] = coarse.vert(he);
+            fine.heFace[a] = NO_INDEX;
+            fine.heFace[b] = NO_INDEX;
+        }
+    });
+
+    // original verts are pointed to by the second half of their old representative
+    parallelFor(0, numbering.numVerts, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex v = static_cast<MeshIndex>(begin); v < end; ++v) {
+            MeshIndex he = coarse.vertexEdge(v);
+            fine.vertEdges[v] = he == NO_INDEX ? NO_INDEX : numbering.halfB(he);
+        }
+    });
+}
+
+// The point rules, written once for anything that can be weighted and summed.
+// Each rule adds a fine point's terms to a sink: sink.addCoarse(v, w) for a
+// coarse vert and sink.addFine(p, w) for a fine point made by an earlier pass
+// (face points before edge points before vertex points).
+
+//face point: the centroid of the face
+template <typename Sink>
+void CatmullClark::facePointRule(const HalfEdgeMesh& coarse, const Numbering& numbering, MeshIndex f, Sink& sink) {
+    const MeshIndex numSides = numbering.faceStart[f + 1] - numbering.faceStart[f];
+    const float weight = 1.0f / static_cast<float>(numSides);
+    for (MeshIndex corner : faceVertices(coarse, f)) {
+        sink.addCoarse(corner, weight);
+    }
+}
+
+//edge point: the average of the edge's verts and its two face points
+//(a boundary edge only has one face point and is split at its midpoint)
+template <typename Sink>
+void CatmullClark::edgePointRule(const HalfEdgeMesh& coarse, const Numbering& numbering, MeshIndex he, Sink& sink) {
+    const MeshIndex sym = coarse.sym(he);
+    if (coarse.isBoundary(he) || coarse.isBoundary(sym)) {
+        sink.addCoarse(coarse.vert(he), 0.5f);
+        sink.addCoarse(coarse.vert(sym), 0.5f);
+    } else {
+        sink.addCoarse(coarse.vert(he), 0.25f);
+        sink.addCoarse(coarse.vert(sym), 0.25f);
+        sink.addFine(numbering.facePoint(coarse.face(he)), 0.25f);
+        sink.addFine(numbering.facePoint(coarse.face(sym)), 0.25f);
+    }
+}
+
+//vertex point: original verts move to a smoothed position based on their
+//neighbouring verts and adjacent face points
+template <typename Sink>
+void CatmullClark::vertexPointRule(const HalfEdgeMesh& coarse, const Numbering& numbering, MeshIndex v, Sink& sink) {
+    const VertexHalfEdges fan = vertexHalfEdges(coarse, v);
+    if (fan.empty()) { //vert isn't used by any face
+        sink.addCoarse(v, 1.0f);
+        return;
+    }
+
+    // count the adjacent edges and look for a boundary among the HEs pointing to v
+    float n = 0;
+    MeshIndex boundaryEdge = NO_INDEX;
+    for (MeshIndex he : fan) {
+        if (coarse.isBoundary(he)) boundaryEdge = he;
+        n += 1.0f;
+    }
+
+    if (boundaryEdge != NO_INDEX) {
+        // boundary verts only follow the two boundary edge points on either side of them
+        sink.addCoarse(v, 0.5f);
+        sink.addFine(numbering.edgePoint(boundaryEdge), 0.25f);
+        sink.addFine(numbering.edgePoint(coarse.next(boundaryEdge)), 0.25f);
+        return;
+    }
+
+    // (n - 2)/n v + (sum of neighbouring verts)/n^2 + (sum of face points)/n^2,
+    // which makes regular regions bicubic B-spline patches
+    const float ringWeight = 1.0f / (n * n);
+    sink.addCoarse(v, (n - 2.0f) / n);
+    for (MeshIndex he : fan) {
+        sink.addCoarse(coarse.vert(coarse.sym(he)), ringWeight); //tail of he
+        sink.addFine(numbering.facePoint(coarse.face(he)), ringWeight);
+    }
+}
+
+//sums a rule's terms straight into a position
+struct CatmullClark::PositionSum {
+    const HalfEdgeMesh& coarse;
+    const HalfEdgeMesh& fine;
+    glm::vec3 total{0.0f};
+
+    void addCoarse(MeshIndex v, float weight) { total += weight * coarse.position(v); }
+    void addFine(MeshIndex p, float weight) { total += weight * fine.position(p); }
+};
+
+//sums a rule's terms into a stencil row over the coarse verts; a fine point
+//is replaced by the row an earlier pass built for it
+struct CatmullClark::StencilSum {
+    const Numbering& numbering;
+    const StencilTable& faceRows;
+    const StencilTable& edgeRows;
+    StencilAccumulator& accumulator;
+
+    void addCoarse(MeshIndex v, float weight) { accumulator.add(v, weight); }
+    void addFine(MeshIndex p, float weight) {
+        const MeshIndex firstEdgePoint = numbering.numVerts + numbering.numFaces;
+        const StencilTable& rows = p < firstEdgePoint ? faceRows : edgeRows;
+        rows.forEachEntry(p < firstEdgePoint ? p - numbering.numVerts : p - firstEdgePoint,
+                          [&](MeshIndex v, float rowWeight) { accumulator.add(v, weight * rowWeight); });
+    }
+};
+
+//face points, then edge points, then smoothed original verts
+void CatmullClark::refinePositions(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine) {
+    parallelFor(0, numbering.numFaces, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex f = static_cast<MeshIndex>(begin); f < end; ++f) {
+            PositionSum sum{coarse, fine};
+            facePointRule(coarse, numbering, f, sum);
+            fine.positions[numbering.facePoint(f)] = sum.total;
+        }
+    });
+
+    parallelFor(0, coarse.numHalfEdges(), grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            if (numbering.side(he)) continue; //one HE per edge
+            PositionSum sum{coarse, fine};
+            edgePointRule(coarse, numbering, he, sum);
+            fine.positions[numbering.edgePoint(he)] = sum.total;
+        }
+    });
+
+    parallelFor(0, numbering.numVerts, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex v = static_cast<MeshIndex>(begin); v < end; ++v) {
+            PositionSum sum{coarse, fine};
+            vertexPointRule(coarse, numbering, v, sum);
+            fine.positions[v] = sum.total;
+        }
+    });
+}
+
+//the same three passes as refinePositions, but every fine point becomes a row of
+//weights over the coarse verts. Rows are stored in fine vertex order
+StencilTable CatmullClark::refineStencils(const HalfEdgeMesh& coarse, const Numbering& numbering) {
+    // the HE each edge point is made from, the one on side 0
+    std::vector<MeshIndex> edgeHEs(numbering.numEdges);
+    parallelFor(0, coarse.numHalfEdges(), grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            if (!numbering.side(he)) edgeHEs[numbering.edge(he)] = he;
+        }
+    });
+
+    const MeshIndex numSources = numbering.numVerts;
+    StencilTable faceRows;
+    StencilTable edgeRows;
+    faceRows = StencilTable::build(numbering.numFaces, numSources, [&](MeshIndex f, StencilAccumulator& accumulator) {
+        StencilSum sum{numbering, faceRows, edgeRows, accumulator};
+        facePointRule(coarse, numbering, f, sum);
+    });
+    edgeRows = StencilTable::build(numbering.numEdges, numSources, [&](MeshIndex e, StencilAccumulator& accumulator) {
+        StencilSum sum{numbering, faceRows, edgeRows, accumulator};
+        edgePointRule(coarse, numbering, edgeHEs[e], sum);
+    });
+    StencilTable rows = StencilTable::build(numbering.numVerts, numSources, [&](MeshIndex v, StencilAccumulator& accumulator) {
+        StencilSum sum{numbering, faceRows, edgeRows, accumulator};
+        vertexPointRule(coarse, numbering, v, sum);
+    });
+    rows.append(faceRows);
+    rows.append(edgeRows);
+    return rows;
+}
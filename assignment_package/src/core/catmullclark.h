@@ -0,0 +1,54 @@
+#ifndef CATMULLCLARK_H
+#define CATMULLCLARK_H
+
+#include "halfedgemesh.h"
+#include "stenciltable.h"
+
+// Catmull-Clark subdivision that never edits the coarse mesh. It works in two
+// phases over the coarse arrays and writes into a separate fine mesh.
+//
+// Topology: every n-gon becomes n quads. Each fine element's index follows from
+// its coarse parent with a closed-form formula, so all faces are rewired in
+// parallel with no lookups:
+//   verts  [0, V) keep their ids, face point f is V + f, edge point e is V + F + e
+//   quads  face f's j-th quad is faceStart[f] + j (prefix sum of face valences)
+//   HEs    coarse HE h on edge e, side s, splits into halfA (tail -> edge point)
+//          and halfB (edge point -> head) at 4e + {0, 2} or 4e + {3, 1};
+//          the spokes of quad q are 4E + 2q (edge point -> face point) and 4E + 2q + 1
+// so twins sit at 2k and 2k + 1, and the fine mesh is built Paired.
+//
+// Positions: face points, edge points and vertex points are then computed in
+// three data-parallel passes, each one reading the coarse mesh and the earlier
+// passes' output only. The same point rules can instead produce a stencil table,
+// the weights of the coarse verts in every fine vert, so a cage whose verts move
+// can be re-evaluated later without refining its topology again.
+class CatmullClark {
+public:
+    //fine gets one level of subdivision of coarse, in coarse's twin layout
+    static void subdivide(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine);
+
+    //like subdivide, and also returns the table that makes fine's verts out of
+    //coarse's verts (one row per fine vert)
+    static StencilTable subdivideWithStencils(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine);
+
+    //fine's element counts: V + F + E verts, one quad per interior HE and
+    //two HEs per coarse HE plus two per quad
+    static MeshSizes refinedSizes(const HalfEdgeMesh& coarse);
+
+private:
+    struct Numbering;
+    static void refineTopology(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine);
+    static void refinePositions(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine);
+    static StencilTable refineStencils(const HalfEdgeMesh& coarse, const Numbering& numbering);
+
+    struct PositionSum;
+    struct StencilSum;
+    template <typename Sink>
+    static void facePointRule(const HalfEdgeMesh& coarse, const Numbering& numbering, MeshIndex f, Sink& sink);
+    template <typename Sink>
+    static void edgePointRule(const HalfEdgeMesh& coarse, const Numbering& numbering, MeshIndex he, Sink& sink);
+    template <typename Sink>
+    static void vertexPointRule(const HalfEdgeMesh& coarse, const Numbering& numbering, MeshIndex v, Sink& sink);
+};
+
+#endif // CATMULLCLARK_H
@@ -0,0 +1,114 @@
+#ifndef CIRCULATORS_H
+#define CIRCULATORS_H
+
+#include "halfedgemesh.h"
+#include <cstddef>
+#include <iterator>
+
+// Ranges over the two cycles every traversal in the kernel walks, read straight
+// off the mesh's arrays, so walking them never allocates:
+//   a face's loop  its HEs in next() order from faceEdge(f), or the verts they point to
+//   a vert's fan   the HEs pointing at it in sym(next()) order from vertexEdge(v),
+//                  or their faces with the boundary gaps skipped
+// They work with range-for and with the standard algorithms:
+//   for (MeshIndex v : faceVertices(mesh, f)) ...
+//   std::any_of(fan.begin(), fan.end(), [&](MeshIndex he) { return mesh.isBoundary(he); })
+// A vert's fan is the one the subdivision rules use, so a pinched vert's other
+// fans aren't reached. The mesh mustn't change its topology while a range is walked.
+
+enum class CycleStep {
+    Face, //he -> next(he)
+    Fan   //he -> sym(next(he)), the next HE pointing at the same vert
+};
+
+enum class CycleValue {
+    HalfEdge,
+    Vertex, //vert(he)
+    Face    //face(he), skipping boundary HEs
+};
+
+// every HE of one cycle, starting and ending at start. A NO_INDEX start (the fan
+// of a vert no face uses) is an empty range
+template <CycleStep step, CycleValue value>
+class CycleRange {
+public:
+    class iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag; //dereferences to a value, not a reference
+        using value_type = MeshIndex;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = MeshIndex;
+
+        iterator() = default;
+
+        MeshIndex operator*() const {
+            if constexpr (value == CycleValue::Vertex) return mesh->vert(he);
+            else if constexpr (value == CycleValue::Face) return mesh->face(he);
+            else return he;
+        }
+        MeshIndex halfEdge() const { return he; } //the HE the iterator is on, whatever it yields
+
+        iterator& operator++() {
+            advance();
+            skipBoundary();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator& other) const { return he == other.he && wrapped == other.wrapped; }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class CycleRange;
+
+        const HalfEdgeMesh* mesh = nullptr;
+        MeshIndex start = NO_INDEX;
+        MeshIndex he = NO_INDEX;
+        bool wrapped = true; //back at start after a full turn
+
+        iterator(const HalfEdgeMesh* mesh, MeshIndex start, bool wrapped)
+            : mesh(mesh), start(start), he(start), wrapped(wrapped) {}
+
+        void advance() {
+            he = step == CycleStep::Face ? mesh->next(he) : mesh->sym(mesh->next(he));
+            wrapped = he == start;
+        }
+        void skipBoundary() {
+            if constexpr (value == CycleValue::Face) {
+                while (!wrapped && mesh->isBoundary(he)) advance();
+            }
+        }
+    };
+
+    CycleRange(const HalfEdgeMesh& mesh, MeshIndex start) : mesh(&mesh), start(start) {}
+
+    iterator begin() const {
+        iterator it(mesh, start, start == NO_INDEX);
+        it.skipBoundary();
+        return it;
+    }
+    iterator end() const { return iterator(mesh, start, true); }
+    bool empty() const { return begin() == end(); }
+
+private:
+    const HalfEdgeMesh* mesh;
+    MeshIndex start;
+};
+
+using FaceHalfEdges = CycleRange<CycleStep::Face, CycleValue::HalfEdge>;
+using FaceVertices = CycleRange<CycleStep::Face, CycleValue::Vertex>;
+using VertexHalfEdges = CycleRange<CycleStep::Fan, CycleValue::HalfEdge>;
+using VertexFaces = CycleRange<CycleStep::Fan, CycleValue::Face>;
+
+inline FaceHalfEdges faceHalfEdges(const HalfEdgeMesh& mesh, MeshIndex f) { return {mesh, mesh.faceEdge(f)}; }
+inline FaceVertices faceVertices(const HalfEdgeMesh& mesh, MeshIndex f) { return {mesh, mesh.faceEdge(f)}; }
+inline VertexHalfEdges vertexHalfEdges(const HalfEdgeMesh& mesh, MeshIndex v) { return {mesh, mesh.vertexEdge(v)}; }
+inline VertexFaces vertexFaces(const HalfEdgeMesh& mesh, MeshIndex v) { return {mesh, mesh.vertexEdge(v)}; }
+
+#endif // CIRCULATORS_H
@@ -0,0 +1,824 @@
+#include "halfedgemesh.h"
+#include "catmullclark.h"
+#include "circulators.h"
+#include "hedsformat.h"
+#include "loadprogress.h"
+#include "loopsubdivision.h"
+#include "mappedfile.h"
+#include "objparser.h"
+#include "parallel.h"
+#include "radixsort.h"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+
+HalfEdgeMesh::HalfEdgeMesh(TwinLayout layout)
+    : layout(layout) {}
+
+//create new vert and store it in the vertex arrays
+MeshIndex HalfEdgeMesh::createVertex(const glm::vec3& position) {
+    positions.push_back(position);
+    vertEdges.push_back(NO_INDEX);
+    return numVertices() - 1;
+}
+
+//create new face and store it in the face arrays
+MeshIndex HalfEdgeMesh::createFace(const glm::vec3& color) {
+    faceEdges.push_back(NO_INDEX);
+    faceColors.push_back(color);
+    return numFaces() - 1;
+}
+
+//create new HE and store it in the half-edge arrays
+MeshIndex HalfEdgeMesh::createHalfEdge() {
+    assert(layout == TwinLayout::Explicit); //a lone HE would break the he ^ 1 pairing
+    heNext.push_back(NO_INDEX);
+    heSym.push_back(NO_INDEX);
+    heFace.push_back(NO_INDEX);
+    heVert.push_back(NO_INDEX);
+    return numHalfEdges() - 1;
+}
+
+//create a pair of HEs that are each other's sym
+MeshIndex HalfEdgeMesh::createEdge() {
+    MeshIndex he = numHalfEdges();
+    heNext.insert(heNext.end(), 2, NO_INDEX);
+    heFace.insert(heFace.end(), 2, NO_INDEX);
+    heVert.insert(heVert.end(), 2, NO_INDEX);
+    if (layout == TwinLayout::Explicit) {
+        heSym.push_back(he + 1);
+        heSym.push_back(he);
+    }
+    return he;
+}
+
+//switch how syms are stored. Going to Paired renumbers every HE so twins sit at
+//2k and 2k + 1, which requires every HE to already have a sym
+void HalfEdgeMesh::setTwinLayout(TwinLayout newLayout) {
+    if (newLayout == layout) return;
+
+    if (newLayout == TwinLayout::Explicit) {
+        heSym.resize(numHalfEdges());
+        for (MeshIndex he = 0; he < numHalfEdges(); ++he) {
+            heSym[he] = he ^ 1u;
+        }
+        layout = newLayout;
+        return;
+    }
+
+    //give each twin pair consecutive ids
+    std::vector<MeshIndex> newIndex(numHalfEdges(), NO_INDEX);
+    MeshIndex numPairs = 0;
+    for (MeshIndex he = 0; he < numHalfEdges(); ++he) {
+        assert(heSym[he] != NO_INDEX);
+        if (he < heSym[he]) {
+            newIndex[he] = 2 * numPairs;
+            newIndex[heSym[he]] = 2 * numPairs + 1;
+            ++numPairs;
+        }
+    }
+
+    std::vector<MeshIndex> newNext(numHalfEdges());
+    std::vector<MeshIndex> newFace(numHalfEdges());
+    std::vector<MeshIndex> newVert(numHalfEdges());
+    for (MeshIndex he = 0; he < numHalfEdges(); ++he) {
+        newNext[newIndex[he]] = newIndex[heNext[he]];
+        newFace[newIndex[he]] = heFace[he];
+        newVert[newIndex[he]] = heVert[he];
+    }
+    heNext.swap(newNext);
+    heFace.swap(newFace);
+    heVert.swap(newVert);
+    heSym.clear();
+    heSym.shrink_to_fit();
+
+    for (MeshIndex& he : faceEdges) {
+        he = newIndex[he];
+    }
+    for (MeshIndex& he : vertEdges) {
+        if (he != NO_INDEX) he = newIndex[he];
+    }
+    layout = newLayout;
+}
+
+void HalfEdgeMesh::clear() {
+    positions.clear();
+    vertEdges.clear();
+    faceEdges.clear();
+    faceColors.clear();
+    heNext.clear();
+    heSym.clear();
+    heFace.clear();
+    heVert.clear();
+}
+
+void HalfEdgeMesh::reserveAdditional(const MeshSizes& added) {
+    const std::size_t numVerts = std::size_t(numVertices()) + added.numVertices;
+    const std::size_t numFacesTotal = std::size_t(numFaces()) + added.numFaces;
+    const std::size_t numHEs = std::size_t(numHalfEdges()) + added.numHalfEdges;
+    reserveAtLeast(positions, numVerts);
+    reserveAtLeast(vertEdges, numVerts);
+    reserveAtLeast(faceEdges, numFacesTotal);
+    reserveAtLeast(faceColors, numFacesTotal);
+    reserveAtLeast(heNext, numHEs);
+    if (layout == TwinLayout::Explicit) reserveAtLeast(heSym, numHEs);
+    reserveAtLeast(heFace, numHEs);
+    reserveAtLeast(heVert, numHEs);
+}
+
+glm::vec3 HalfEdgeMesh::randomColor() {
+    static thread_local std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    float r = dist(rng);
+    float g = dist(rng);
+    float b = dist(rng);
+    return glm::vec3(r, g, b);
+}
+
+//load an obj file and make a mesh construct. The file is mapped and tokenized
+//in place, see parseOBJ. Parsing is the first half of the progress, building the second
+bool HalfEdgeMesh::loadOBJ(const std::string& filePath, LoadProgress* progress) {
+    clear();
+
+    MappedFile objFile; //check for file opening errors
+    if (!objFile.open(filePath)) {
+        std::cerr << "Error: Could not open OBJ file." << std::endl;
+        return false;
+    }
+
+    ObjPolygons polygons;
+    std::string error;
+    if (progress) progress->beginStage(0.0f, 0.5f);
+    if (!parseOBJ(objFile.data(), objFile.data() + objFile.size(), polygons, error, 0, progress)) {
+        if (!progress || !progress->isCancelled()) std::cerr << "Error: OBJ " << error << std::endl;
+        return false;
+    }
+    objFile.close();
+
+    if (progress) progress->beginStage(0.5f, 1.0f);
+    MeshDefects defects = buildFromPolygons(polygons, progress);
+    if (progress && progress->isCancelled()) return false;
+    if (!defects.nonManifoldEdges.empty()) {
+        std::cerr << "Warning: OBJ has " << defects.nonManifoldEdges.size()
+                  << " non-manifold edges (more than two faces), first between verts "
+                  << defects.nonManifoldEdges[0].first + 1 << " and " << defects.nonManifoldEdges[0].second + 1
+                  << ". They are kept as boundaries." << std::endl;
+    }
+    if (defects.misorientedEdges > 0) {
+        std::cerr << "Warning: OBJ has " << defects.misorientedEdges
+                  << " edges between faces with opposite orientations. They are kept as boundaries." << std::endl;
+    }
+    return true;
+}
+
+//make a half-edge mesh out of a polygon soup. Corner c of the soup becomes HE c,
+//so next/vert/face follow from the face offsets and are filled in parallel
+MeshDefects HalfEdgeMesh::buildFromPolygons(const ObjPolygons& polygons, LoadProgress* progress) {
+    // clear existing mesh data. Twins are matched with an explicit sym array,
+    // then the mesh is converted back to the requested layout at the end
+    clear();
+    TwinLayout targetLayout = layout;
+    layout = TwinLayout::Explicit;
+
+    const MeshIndex numFacesIn = polygons.numFaces();
+    const MeshIndex numCorners = static_cast<MeshIndex>(polygons.cornerVerts.size());
+    const std::size_t grain = 1 << 14;
+
+    positions = polygons.positions;
+    vertEdges.assign(positions.size(), NO_INDEX);
+    faceEdges.resize(numFacesIn);
+    faceColors.resize(numFacesIn);
+    heNext.resize(numCorners);
+    heSym.assign(numCorners, NO_INDEX);
+    heFace.resize(numCorners);
+    heVert.assign(polygons.cornerVerts.begin(), polygons.cornerVerts.end());
+
+    parallelFor(0, numFacesIn, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex f = static_cast<MeshIndex>(begin); f < end; ++f) {
+            const MeshIndex first = polygons.faceOffsets[f];
+            const MeshIndex last = polygons.faceOffsets[f + 1] - 1;
+            for (MeshIndex he = first; he < last; ++he) {
+                heNext[he] = he + 1;
+                heFace[he] = f;
+            }
+            heNext[last] = first; // close the loop for the face
+            heFace[last] = f;
+            faceEdges[f] = first;
+            faceColors[f] = randomColor(); // new face with a random color
+        }
+    });
+
+    // a vert's representative is the last HE pointing at it, as when HEs were made one at a time
+    for (MeshIndex he = 0; he < numCorners; ++he) {
+        vertEdges[heVert[he]] = he;
+    }
+
+    // each step below is one uninterruptible parallel pass, so cancellation is checked between them
+    auto cancelled = [&](float stageFraction) {
+        if (!progress) return false;
+        progress->report(stageFraction);
+        if (!progress->isCancelled()) return false;
+        clear();
+        layout = targetLayout;
+        return true;
+    };
+    if (cancelled(0.2f)) return MeshDefects();
+    MeshDefects defects = matchTwins();
+    if (cancelled(0.8f)) return MeshDefects();
+    linkBoundaryLoops();
+    if (cancelled(0.9f)) return MeshDefects();
+    setTwinLayout(targetLayout);
+    if (progress) progress->report(1.0f);
+    return defects;
+}
+
+//pair up every HE with its sym. Each HE emits its undirected edge packed into a
+//64-bit key (smaller vert in the high word); after a radix sort the HEs of one
+//edge sit next to each other, and a run of two opposite HEs is a twin pair.
+//HEs left unpaired become boundary HEs in linkBoundaryLoops
+MeshDefects HalfEdgeMesh::matchTwins() {
+    const MeshIndex numHEs = numHalfEdges();
+    const std::size_t grain = 1 << 14;
+
+    std::vector<MeshIndex> tail(numHEs); //vert at the start of each HE
+    parallelFor(0, numHEs, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            tail[heNext[he]] = heVert[he];
+        }
+    });
+
+    std::vector<KeyedIndex> edgeKeys(numHEs);
+    parallelFor(0, numHEs, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            uint64_t lo = std::min(tail[he], heVert[he]);
+            uint64_t hi = std::max(tail[he], heVert[he]);
+            edgeKeys[he] = {(lo << 32) | hi, he};
+        }
+    });
+
+    // only the low bytes of each vert index can be nonzero
+    unsigned vertBytes = 1;
+    while (vertBytes < 4 && (numVertices() >> (8 * vertBytes)) != 0) ++vertBytes;
+    uint8_t byteMask = static_cast<uint8_t>(((1u << vertBytes) - 1) * 0x11u);
+    parallelRadixSort(edgeKeys, byteMask);
+
+    // walk runs of equal keys in parallel. Every range starts at the first run that
+    // begins inside it and finishes the run it ends in
+    const unsigned numRanges = static_cast<unsigned>(std::max<std::size_t>(1,
+        std::min<std::size_t>(workerCount(), numHEs / grain)));
+    std::vector<MeshDefects> rangeDefects(numRanges);
+    parallelTasks(numRanges, [&](unsigned r) {
+        std::size_t i = std::size_t(numHEs) * r / numRanges;
+        std::size_t end = std::size_t(numHEs) * (r + 1) / numRanges;
+        while (i > 0 && i < numHEs && edgeKeys[i].key == edgeKeys[i - 1].key) ++i;
+
+        std::vector<MeshIndex> forward, backward; //run members by direction along the edge
+        while (i < end) {
+            std::size_t runEnd = i + 1;
+            while (runEnd < numHEs && edgeKeys[runEnd].key == edgeKeys[i].key) ++runEnd;
+
+            if (runEnd - i == 2) {
+                MeshIndex he1 = edgeKeys[i].value;
+                MeshIndex he2 = edgeKeys[i + 1].value;
+                if (heVert[he1] != heVert[he2]) {
+                    heSym[he1] = he2;
+                    heSym[he2] = he1;
+                } else {
+                    ++rangeDefects[r].misorientedEdges; //neighboring faces disagree on orientation
+                }
+            } else if (runEnd - i > 2) {
+                // more than two faces on one edge: pair opposite HEs in file order
+                // and leave the rest on the boundary
+                forward.clear();
+                backward.clear();
+                for (std::size_t k = i; k < runEnd; ++k) {
+                    MeshIndex he = edgeKeys[k].value;
+                    (tail[he] < heVert[he] ? forward : backward).push_back(he);
+                }
+                for (std::size_t k = 0; k < std::min(forward.size(), backward.size()); ++k) {
+                    heSym[forward[k]] = backward[k];
+                    heSym[backward[k]] = forward[k];
+                }
+                uint64_t key = edgeKeys[i].key;
+                rangeDefects[r].nonManifoldEdges.emplace_back(static_cast<MeshIndex>(key >> 32),
+                                                              static_cast<MeshIndex>(key));
+            }
+            i = runEnd;
+        }
+    });
+
+    MeshDefects defects;
+    for (const MeshDefects& range : rangeDefects) {
+        defects.nonManifoldEdges.insert(defects.nonManifoldEdges.end(),
+                                        range.nonManifoldEdges.begin(), range.nonManifoldEdges.end());
+        defects.misorientedEdges += range.misorientedEdges;
+    }
+    return defects;
+}
+
+//every HE left without a sym lies on a boundary; give it a boundary HE (face NO_INDEX)
+//as its sym and chain those boundary HEs into loops so sym/next traversals never dead-end
+void HalfEdgeMesh::linkBoundaryLoops() {
+    MeshIndex numInteriorHEs = numHalfEdges();
+
+    std::vector<MeshIndex> prev(numInteriorHEs); //HE before each HE in its face
+    for (MeshIndex he = 0; he < numInteriorHEs; ++he) {
+        prev[next(he)] = he;
+    }
+
+    for (MeshIndex he = 0; he < numInteriorHEs; ++he) {
+        if (sym(he) != NO_INDEX) continue;
+        MeshIndex boundaryHE = createHalfEdge();
+        heVert[boundaryHE] = vert(prev[he]); //don't make a boundary HE the vert's representative edge
+        setSym(he, boundaryHE);
+    }
+
+    // a boundary HE continues with the boundary HE leaving its vert on the far side
+    // of the same fan of faces, found by turning around the vert away from the hole.
+    // Verts where several fans touch then get one loop per gap
+    for (MeshIndex he = numInteriorHEs; he < numHalfEdges(); ++he) {
+        MeshIndex out = sym(he);
+        while (sym(prev[out]) < numInteriorHEs) {
+            out = sym(prev[out]);
+        }
+        setNext(he, sym(prev[out]));
+    }
+}
+
+//write every array into a .heds file. The file is written next to its final path
+//and renamed over it, so a reader never maps a half-written file
+bool HalfEdgeMesh::saveHEDS(const std::string& filePath) const {
+    HedsHeader header = {};
+    std::memcpy(header.magic, HEDS_MAGIC, sizeof(header.magic));
+    header.version = HEDS_VERSION;
+    header.byteOrder = HEDS_BYTE_ORDER;
+    header.twinLayout = layout == TwinLayout::Paired ? 1 : 0;
+    header.numVertices = numVertices();
+    header.numFaces = numFaces();
+    header.numHalfEdges = numHalfEdges();
+
+    const std::array<HedsSection, HEDS_NUM_SECTIONS> sections = hedsSections(header);
+    const std::array<const void*, HEDS_NUM_SECTIONS> arrays = {
+        positions.data(), vertEdges.data(), faceEdges.data(), faceColors.data(),
+        heNext.data(), heSym.data(), heFace.data(), heVert.data()};
+    header.payloadSize = sections.back().offset + sections.back().size - sizeof(HedsHeader);
+    for (int s = 0; s < HEDS_NUM_SECTIONS; ++s) {
+        header.checksum = hedsChecksum(header.checksum, arrays[s], sections[s].size);
+    }
+
+    const std::string tempPath = filePath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not write HEDS file." << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int s = 0; s < HEDS_NUM_SECTIONS; ++s) {
+        out.write(static_cast<const char*>(arrays[s]), static_cast<std::streamsize>(sections[s].size));
+    }
+    out.close();
+
+    std::error_code fsError;
+    bool written = !out.fail();
+    if (written) std::filesystem::rename(tempPath, filePath, fsError);
+    if (!written || fsError) {
+        std::cerr << "Error: Could not write HEDS file." << std::endl;
+        std::filesystem::remove(tempPath, fsError);
+        return false;
+    }
+    return true;
+}
+
+//read a .heds file: one mapping, a checksum over it, a bulk copy per array and a
+//connectivity check. The mesh keeps its own twin layout whatever the file stores
+bool HalfEdgeMesh::loadHEDS(const std::string& filePath, LoadProgress* progress) {
+    clear();
+    const TwinLayout targetLayout = layout;
+
+    MappedFile file;
+    if (!file.open(filePath)) {
+        std::cerr << "Error: Could not open HEDS file." << std::endl;
+        return false;
+    }
+    auto fail = [&](const std::string& error) {
+        std::cerr << "Error: HEDS " << error << std::endl;
+        clear();
+        layout = targetLayout;
+        return false;
+    };
+    auto cancelled = [&](float fraction) {
+        if (!progress) return false;
+        progress->report(fraction);
+        if (!progress->isCancelled()) return false;
+        clear();
+        layout = targetLayout;
+        return true;
+    };
+
+    HedsHeader header;
+    if (file.size() < sizeof(header)) return fail("file is truncated");
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, HEDS_MAGIC, sizeof(header.magic)) != 0) return fail("file has no HEDS signature");
+    if (header.byteOrder != HEDS_BYTE_ORDER) return fail("file was written with the other byte order");
+    if (header.version != HEDS_VERSION) return fail("version " + std::to_string(header.version) + " is not supported");
+    if (header.twinLayout > 1) return fail("header is corrupt");
+
+    const std::array<HedsSection, HEDS_NUM_SECTIONS> sections = hedsSections(header);
+    const uint64_t fileSize = sections.back().offset + sections.back().size;
+    if (header.payloadSize != fileSize - sizeof(header) || file.size() != fileSize) {
+        return fail("file size doesn't match its header");
+    }
+    uint64_t checksum = 0;
+    for (int s = 0; s < HEDS_NUM_SECTIONS; ++s) {
+        checksum = hedsChecksum(checksum, file.data() + sections[s].offset, sections[s].size);
+        if (cancelled(0.5f * (s + 1) / static_cast<float>(HEDS_NUM_SECTIONS))) return false;
+    }
+    if (checksum != header.checksum) return fail("checksum mismatch, the file is corrupt");
+
+    auto copySection = [&](HedsSectionId s, auto& array) {
+        array.resize(sections[s].size / sizeof(array[0]));
+        if (!array.empty()) std::memcpy(static_cast<void*>(array.data()), file.data() + sections[s].offset, sections[s].size);
+    };
+    copySection(HEDS_POSITIONS, positions);
+    copySection(HEDS_VERT_EDGES, vertEdges);
+    copySection(HEDS_FACE_EDGES, faceEdges);
+    copySection(HEDS_FACE_COLORS, faceColors);
+    copySection(HEDS_NEXT, heNext);
+    copySection(HEDS_SYM, heSym);
+    copySection(HEDS_FACE, heFace);
+    copySection(HEDS_VERT, heVert);
+    file.close();
+    if (cancelled(0.7f)) return false;
+
+    layout = header.twinLayout == 1 ? TwinLayout::Paired : TwinLayout::Explicit;
+    std::string error;
+    if (!checkConnectivity(error)) return fail(error);
+    if (cancelled(0.9f)) return false;
+    setTwinLayout(targetLayout);
+    if (progress) progress->report(1.0f);
+    return true;
+}
+
+//make sure traversals can't leave the arrays or loop forever: every index is in
+//range, sym pairs HEs up, next is a permutation (so next() walks closed loops)
+//and every loop stays on one face
+bool HalfEdgeMesh::checkConnectivity(std::string& error) const {
+    const MeshIndex numHEs = numHalfEdges();
+    if (layout == TwinLayout::Paired && numHEs % 2 != 0) {
+        error = "has an odd number of paired half-edges";
+        return false;
+    }
+
+    std::atomic<bool> halfEdgesOk{true};
+    parallelFor(0, numHEs, 1 << 16, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            MeshIndex s = sym(he);
+            MeshIndex n = heNext[he];
+            MeshIndex f = heFace[he];
+            if (s >= numHEs || sym(s) != he || s == he || n >= numHEs || heFace[n] != f ||
+                heVert[he] >= numVertices() || (f != NO_INDEX && f >= numFaces())) {
+                halfEdgesOk = false;
+                return;
+            }
+        }
+    });
+    if (!halfEdgesOk) {
+        error = "has a half-edge with an invalid next, sym, face or vert";
+        return false;
+    }
+
+    std::vector<uint8_t> hasPrev(numHEs, 0);
+    for (MeshIndex he = 0; he < numHEs; ++he) {
+        if (hasPrev[heNext[he]]) {
+            error = "has two half-edges with the same next";
+            return false;
+        }
+        hasPrev[heNext[he]] = 1;
+    }
+
+    for (MeshIndex f = 0; f < numFaces(); ++f) {
+        if (faceEdges[f] >= numHEs || heFace[faceEdges[f]] != f) {
+            error = "has a face whose edge doesn't lie on it";
+            return false;
+        }
+    }
+    for (MeshIndex v = 0; v < numVertices(); ++v) {
+        if (vertEdges[v] != NO_INDEX && (vertEdges[v] >= numHEs || heVert[vertEdges[v]] != v)) {
+            error = "has a vertex whose edge doesn't point to it";
+            return false;
+        }
+    }
+    return true;
+}
+
+//split an edge by adding a vertex and 2 new halfedges
+MeshIndex HalfEdgeMesh::splitEdge(MeshIndex selectedHE) {
+    reserveAdditional(splitEdgeGrowth());
+    if (layout == TwinLayout::Paired) {
+        return splitEdgePaired(selectedHE);
+    }
+
+    MeshIndex HE1 = sym(selectedHE);
+    MeshIndex HE2 = selectedHE;
+    MeshIndex V1 = vert(HE1);
+    MeshIndex V2 = vert(HE2);
+    MeshIndex newHE1 = createHalfEdge();
+    MeshIndex newHE2 = createHalfEdge();
+
+    // create a new vert at the midpoint bw two vertices
+    glm::vec3 midPos = (position(V1) + position(V2)) / 2.0f;
+    MeshIndex midVertex = createVertex(midPos); //not yet attached to any part of the mesh
+
+    // update references in the new HalfEdges
+    setVertex(newHE1, V1);
+    setVertex(newHE2, V2);
+    setNext(newHE1, next(HE1));
+    setNext(newHE2, next(HE2));
+    setSym(newHE1, HE2);
+    setSym(newHE2, HE1);
+    setFace(newHE1, face(HE1));
+    setFace(newHE2, face(HE2));
+
+    //adjust next and vert pointers of original HEs
+    setVertex(HE1, midVertex);
+    setVertex(HE2, midVertex);
+    setNext(HE1, newHE1);
+    setNext(HE2, newHE2);
+
+    return midVertex;
+}
+
+//Paired-layout split: the twins of an edge can't be re-paired, so selectedHE and
+//its sym keep the half near V1 and a new pair takes the half near V2
+MeshIndex HalfEdgeMesh::splitEdgePaired(MeshIndex selectedHE) {
+    MeshIndex HE1 = sym(selectedHE); // V2 -> V1
+    MeshIndex HE2 = selectedHE;      // V1 -> V2
+    MeshIndex V1 = vert(HE1);
+    MeshIndex V2 = vert(HE2);
+
+    // HE1 is re-entered from the new half, so find the HE that currently leads into it
+    MeshIndex prevHE1 = HE1;
+    while (next(prevHE1) != HE1) {
+        prevHE1 = next(prevHE1);
+    }
+
+    MeshIndex midVertex = createVertex((position(V1) + position(V2)) / 2.0f);
+    MeshIndex newHE2 = createEdge(); // mid -> V2, continues HE2's loop
+    MeshIndex newHE1 = sym(newHE2);  // V2 -> mid, leads into HE1
+
+    setVertex(newHE1, midVertex);
+    setNext(newHE1, HE1); // HE1 now runs mid -> V1
+    setFace(newHE1, face(HE1));
+    setNext(prevHE1, newHE1);
+
+    setVertex(newHE2, V2);
+    setNext(newHE2, next(HE2));
+    setFace(newHE2, face(HE2));
+    setVertex(HE2, midVertex); // HE2 now runs V1 -> mid
+    setNext(HE2, newHE2);
+
+    return midVertex;
+}
+
+//helper function to count n edges in face
+int HalfEdgeMesh::countEdgesInFace(MeshIndex f) const {
+    const FaceHalfEdges loop = faceHalfEdges(*this, f);
+    return static_cast<int>(std::distance(loop.begin(), loop.end()));
+}
+
+//a fan over an n-gon adds n - 3 diagonals and n - 3 faces
+MeshSizes HalfEdgeMesh::triangulateFaceGrowth(MeshIndex f) const {
+    MeshIndex numDiagonals = static_cast<MeshIndex>(std::max(countEdgesInFace(f) - 3, 0));
+    return {0, numDiagonals, 2 * numDiagonals};
+}
+
+//segment a face into 2+ faces where all faces are triangles using fan triangulation
+void HalfEdgeMesh::triangulateFace(MeshIndex f) {
+    int numEdges = countEdgesInFace(f);
+    if (numEdges < 3) return;
+    reserveAdditional(triangulateFaceGrowth(f));
+
+    MeshIndex startHE = faceEdge(f);
+    MeshIndex v1 = vert(startHE); //start vertex to connect to all others
+
+    MeshIndex currentHE = next(startHE);
+    for (int i = 0; i < numEdges - 3; ++i) {
+        // Get the vertex to form a triangle with the startVertex
+        MeshIndex v3 = vert(next(currentHE));
+
+        // Create new symmetric half-edges for the diagonal
+        MeshIndex diagonal1 = createEdge();
+        MeshIndex diagonal2 = sym(diagonal1);
+        setVertex(diagonal1, v3); // Diagonal1 points from v1 to v3
+        setVertex(diagonal2, v1); // Diagonal2 points from v3 to v1
+
+        // Create one new triangular face (reuse the original face for the other triangle)
+        MeshIndex newFace = createFace(randomColor());
+
+        // Set up the original face's remaining half-edges to be part of the next iteration
+        setNext(startHE, diagonal1);
+        setNext(diagonal1, next(next(currentHE)));
+        setFace(diagonal1, f);
+
+        // Update half-edges to create the next triangle (v1, v2, v3) using the new face
+        setNext(next(currentHE), diagonal2);
+        setNext(diagonal2, currentHE);
+        setFace(diagonal2, newFace);
+        setFace(next(currentHE), newFace);
+        setFace(currentHE, newFace);
+
+        // Advance to the next half-edge for the next iteration
+        currentHE = diagonal1;
+    }
+
+    // Final triangle between startVertex, the last two remaining vertices of the face
+    setNext(next(currentHE), startHE);
+    setNext(startHE, currentHE);
+
+    // Update the face of the original edges to the original face
+    setFace(currentHE, f);
+    setFace(next(currentHE), f);
+    setFace(startHE, f); // Set the edge of the original face to startHE
+}
+
+namespace {
+
+//the faces of a selection (sorted, without repeats or invalid ids) and one HE
+//on every edge of any of them
+struct FaceRegion {
+    std::vector<MeshIndex> faces;
+    std::vector<MeshIndex> edgeHEs;
+    MeshIndex numSides = 0;
+};
+
+FaceRegion collectRegion(const HalfEdgeMesh& mesh, const std::vector<MeshIndex>& selection) {
+    FaceRegion region;
+    for (MeshIndex f : selection) {
+        if (f < mesh.numFaces()) region.faces.push_back(f);
+    }
+    std::sort(region.faces.begin(), region.faces.end());
+    region.faces.erase(std::unique(region.faces.begin(), region.faces.end()), region.faces.end());
+
+    std::unordered_set<MeshIndex> seenEdges;
+    for (MeshIndex f : region.faces) {
+        for (MeshIndex he : faceHalfEdges(mesh, f)) {
+            if (seenEdges.insert(mesh.edge(he)).second) region.edgeHEs.push_back(he);
+            ++region.numSides;
+        }
+    }
+    return region;
+}
+
+//a face point and n - 1 faces per n-gon, an edge point per edge and two HEs per
+//edge split and per spoke
+MeshSizes regionGrowth(const FaceRegion& region) {
+    const MeshIndex numFaces = static_cast<MeshIndex>(region.faces.size());
+    const MeshIndex numEdges = static_cast<MeshIndex>(region.edgeHEs.size());
+    return {numFaces + numEdges, region.numSides - numFaces, 2 * numEdges + 2 * region.numSides};
+}
+
+} // namespace
+
+//one level of Catmull-Clark on the selected faces only, in place. Every selected
+//n-gon becomes n quads around its face point. Its edges are split, so an unselected
+//neighbour gains the edge point as an extra corner: the transition faces are
+//plain polygons, with no T-junctions. Inside the region the usual rules apply;
+//verts and edges on its border stay where they are (edges split at their midpoint),
+//so the unselected faces keep their shape. Only the region is visited
+void HalfEdgeMesh::subdivideFaces(const std::vector<MeshIndex>& selection) {
+    const FaceRegion region = collectRegion(*this, selection);
+    if (region.faces.empty()) return;
+    auto regionFace = [&](MeshIndex f) { //index into region.faces, or NO_INDEX
+        auto it = std::lower_bound(region.faces.begin(), region.faces.end(), f);
+        return it != region.faces.end() && *it == f ? static_cast<MeshIndex>(it - region.faces.begin()) : NO_INDEX;
+    };
+
+    // every new position is computed from the mesh as it is, before any of it changes
+    std::vector<glm::vec3> facePoints(region.faces.size());
+    for (std::size_t k = 0; k < region.faces.size(); ++k) {
+        glm::vec3 sum(0.0f);
+        int numSides = 0;
+        for (MeshIndex corner : faceVertices(*this, region.faces[k])) {
+            sum += position(corner);
+            ++numSides;
+        }
+        facePoints[k] = sum / static_cast<float>(numSides);
+    }
+
+    std::vector<glm::vec3> edgePoints(region.edgeHEs.size());
+    for (std::size_t e = 0; e < region.edgeHEs.size(); ++e) {
+        const MeshIndex he = region.edgeHEs[e];
+        const glm::vec3 midpoint = (position(vert(he)) + position(vert(sym(he)))) / 2.0f;
+        const MeshIndex inside = isBoundary(he) ? NO_INDEX : regionFace(face(he));
+        const MeshIndex outside = isBoundary(sym(he)) ? NO_INDEX : regionFace(face(sym(he)));
+        edgePoints[e] = inside != NO_INDEX && outside != NO_INDEX
+                            ? (midpoint + (facePoints[inside] + facePoints[outside]) / 2.0f) / 2.0f
+                            : midpoint;
+    }
+
+    std::vector<MeshIndex> regionVerts;
+    for (MeshIndex f : region.faces) {
+        const FaceVertices corners = faceVertices(*this, f);
+        regionVerts.insert(regionVerts.end(), corners.begin(), corners.end());
+    }
+    std::sort(regionVerts.begin(), regionVerts.end());
+    regionVerts.erase(std::unique(regionVerts.begin(), regionVerts.end()), regionVerts.end());
+
+    std::vector<glm::vec3> vertPoints(regionVerts.size());
+    for (std::size_t k = 0; k < regionVerts.size(); ++k) {
+        const MeshIndex v = regionVerts[k];
+        float n = 0;
+        bool surrounded = true; //every face around v is selected
+        MeshIndex boundaryEdge = NO_INDEX;
+        glm::vec3 ringSum(0.0f);
+        for (MeshIndex he : vertexHalfEdges(*this, v)) {
+            if (isBoundary(he)) {
+                boundaryEdge = he;
+            } else if (regionFace(face(he)) == NO_INDEX) {
+                surrounded = false;
+            } else {
+                ringSum += position(vert(sym(he))) + facePoints[regionFace(face(he))];
+            }
+            n += 1.0f;
+        }
+
+        if (!surrounded) {
+            vertPoints[k] = position(v);
+        } else if (boundaryEdge != NO_INDEX) {
+            vertPoints[k] = (position(vert(sym(boundaryEdge))) + 6.0f * position(v) +
+                             position(vert(next(boundaryEdge)))) / 8.0f;
+        } else {
+            vertPoints[k] = (n - 2.0f) / n * position(v) + ringSum / (n * n);
+        }
+    }
+
+    // split every edge, then fan each face's quads around its face point
+    reserveAdditional(regionGrowth(region));
+    const MeshIndex firstEdgePoint = numVertices();
+    for (std::size_t e = 0; e < region.edgeHEs.size(); ++e) {
+        setPosition(splitEdge(region.edgeHEs[e]), edgePoints[e]);
+    }
+    for (std::size_t k = 0; k < regionVerts.size(); ++k) {
+        setPosition(regionVerts[k], vertPoints[k]);
+    }
+
+    std::vector<MeshIndex> ring;
+    std::vector<MeshIndex> spokes;
+    for (std::size_t k = 0; k < region.faces.size(); ++k) {
+        const MeshIndex f = region.faces[k];
+
+        // the face now alternates original verts and edge points; ring[2j] runs
+        // into edge point j and ring[2j + 1] out of it
+        MeshIndex start = faceEdge(f);
+        if (vert(start) < firstEdgePoint) start = next(start);
+        const FaceHalfEdges loop(*this, start);
+        ring.assign(loop.begin(), loop.end());
+        const std::size_t numSides = ring.size() / 2;
+
+        // spoke j runs from the face point out to edge point j, its sym back in
+        const MeshIndex facePoint = createVertex(facePoints[k]);
+        spokes.clear();
+        for (std::size_t j = 0; j < numSides; ++j) {
+            spokes.push_back(createEdge());
+        }
+
+        // quad j sits around the original vert after edge point j, the first one keeps f
+        for (std::size_t j = 0; j < numSides; ++j) {
+            const MeshIndex quad = j == 0 ? f : createFace(randomColor());
+            const MeshIndex toCorner = ring[2 * j + 1];
+            const MeshIndex fromCorner = ring[(2 * j + 2) % ring.size()];
+            const MeshIndex in = sym(spokes[(j + 1) % numSides]);
+            const MeshIndex out = spokes[j];
+
+            setNext(toCorner, fromCorner);
+            setNext(fromCorner, in);
+            setNext(in, out);
+            setNext(out, toCorner);
+            setVertex(in, facePoint);
+            setVertex(out, vert(ring[2 * j]));
+            setFace(out, quad);
+            setFace(in, quad);
+            setFace(fromCorner, quad);
+            setFace(toCorner, quad); //start on the HE that points to an original vertex
+        }
+    }
+}
+
+//one level of Catmull-Clark, computed into a new mesh that then replaces this one
+void HalfEdgeMesh::catmullClarkSubdivide() {
+    HalfEdgeMesh fine(layout);
+    CatmullClark::subdivide(*this, fine);
+    *this = std::move(fine);
+}
+
+//one level of Loop, computed into a new mesh that then replaces this one
+bool HalfEdgeMesh::loopSubdivide() {
+    HalfEdgeMesh fine(layout);
+    if (!LoopSubdivision::subdivide(*this, fine)) return false;
+    *this = std::move(fine);
+    return true;
+}
@@ -0,0 +1,169 @@
+#ifndef HALFEDGEMESH_H
+#define HALFEDGEMESH_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <algorithm>
+#include <utility>
+
+// every mesh element is addressed by a 32-bit index into the arrays below
+using MeshIndex = uint32_t;
+constexpr MeshIndex NO_INDEX = 0xFFFFFFFFu; //"null pointer" for indices
+
+struct ObjPolygons;
+class LoadProgress;
+
+// edges that couldn't be paired into a manifold while building from polygons
+struct MeshDefects {
+    std::vector<std::pair<MeshIndex, MeshIndex>> nonManifoldEdges; //verts of edges with 3+ HEs
+    MeshIndex misorientedEdges = 0; //edges whose two HEs run the same way
+};
+
+// element counts of a mesh, or how many elements an operation adds to one
+struct MeshSizes {
+    MeshIndex numVertices = 0;
+    MeshIndex numFaces = 0;
+    MeshIndex numHalfEdges = 0;
+};
+
+// grow v's capacity to at least n. A jump past twice the current capacity (a
+// subdivision) reserves exactly n; smaller ones (a single edge split) double, so
+// a run of small edits still reallocates only O(log n) times
+template <typename T>
+void reserveAtLeast(std::vector<T>& v, std::size_t n) {
+    if (n > v.capacity()) v.reserve(std::max(n, 2 * v.capacity()));
+}
+
+// how a half-edge finds its sym
+enum class TwinLayout {
+    Explicit, // every HE stores its sym index
+    Paired    // HEs are allocated in twin pairs: sym(he) == he ^ 1, edge id == he >> 1
+};
+
+// Qt-free half-edge kernel. Positions and connectivity live in contiguous
+// struct-of-arrays storage (one array per field) instead of one heap object per
+// element, so traversals stream through memory. The GUI layer (Mesh and the
+// Vertex/Face/HalfEdge list items) only holds indices into this class.
+//
+// Boundaries are represented by half-edges whose face is NO_INDEX, so sym()
+// is always valid and boundary half-edges form their own next() loops.
+//
+// In the Paired layout the sym array is not stored at all and every edge has
+// a dense id, so per-edge data can live in a flat array of edgeIndexBound()
+// entries instead of a map keyed on half-edge pairs.
+class HalfEdgeMesh {
+public:
+    HalfEdgeMesh(TwinLayout layout = TwinLayout::Explicit);
+
+    TwinLayout twinLayout() const { return layout; }
+    void setTwinLayout(TwinLayout newLayout); //renumbers HEs when switching to Paired
+
+    //element counts
+    MeshIndex numVertices() const { return static_cast<MeshIndex>(positions.size()); }
+    MeshIndex numFaces() const { return static_cast<MeshIndex>(faceEdges.size()); }
+    MeshIndex numHalfEdges() const { return static_cast<MeshIndex>(heNext.size()); }
+
+    //vertex accessors
+    const glm::vec3& position(MeshIndex v) const { return positions[v]; }
+    MeshIndex vertexEdge(MeshIndex v) const { return vertEdges[v]; } //one of the HEs pointing to v
+    void setPosition(MeshIndex v, const glm::vec3& pos) { positions[v] = pos; }
+    const glm::vec3* positionData() const { return positions.data(); } //all positions, for bulk passes
+    glm::vec3* positionData() { return positions.data(); }
+
+    //face accessors
+    MeshIndex faceEdge(MeshIndex f) const { return faceEdges[f]; } //one of the HEs that lie on f
+    const glm::vec3& faceColor(MeshIndex f) const { return faceColors[f]; }
+    void setFaceColor(MeshIndex f, const glm::vec3& col) { faceColors[f] = col; }
+
+    //half-edge accessors
+    MeshIndex next(MeshIndex he) const { return heNext[he]; }
+    MeshIndex sym(MeshIndex he) const { return layout == TwinLayout::Paired ? (he ^ 1u) : heSym[he]; }
+    MeshIndex face(MeshIndex he) const { return heFace[he]; } //NO_INDEX on boundary HEs
+    MeshIndex vert(MeshIndex he) const { return heVert[he]; } //vert at the end of he
+    bool isBoundary(MeshIndex he) const { return heFace[he] == NO_INDEX; }
+
+    //edge ids, shared by both HEs of an edge and dense in [0, edgeIndexBound())
+    MeshIndex edge(MeshIndex he) const { return layout == TwinLayout::Paired ? (he >> 1) : std::min(he, heSym[he]); }
+    MeshIndex edgeIndexBound() const { return layout == TwinLayout::Paired ? numHalfEdges() / 2 : numHalfEdges(); }
+
+    //half-edge setters, same semantics as the old pointer-based components:
+    //setFace and setVertex also point the face/vertex back at this HE
+    void setNext(MeshIndex he, MeshIndex nextEdge) { heNext[he] = nextEdge; }
+    void setSym(MeshIndex he, MeshIndex symEdge) {
+        if (layout == TwinLayout::Paired) {
+            assert(symEdge == (he ^ 1u)); //twins are fixed by allocation
+            return;
+        }
+        heSym[he] = symEdge;
+        heSym[symEdge] = he;
+    }
+    void setFace(MeshIndex he, MeshIndex f) {
+        heFace[he] = f;
+        if (f != NO_INDEX) faceEdges[f] = he;
+    }
+    void setVertex(MeshIndex he, MeshIndex v) { heVert[he] = v; vertEdges[v] = he; }
+
+    //element creation, each returns the index of the new element
+    MeshIndex createVertex(const glm::vec3& position);
+    MeshIndex createFace(const glm::vec3& color);
+    MeshIndex createHalfEdge(); //Explicit layout only
+    MeshIndex createEdge(); //creates two HEs that are each other's sym, returns the first
+
+    void clear(); //drop every element
+    void reserveAdditional(const MeshSizes& added); //room for an operation's new elements, see reserveAtLeast
+
+    //build from an obj file; returns false (and leaves the mesh empty) on failure.
+    //A cancelled progress also makes the loaders return false, without an error
+    bool loadOBJ(const std::string& filePath, LoadProgress* progress = nullptr);
+    MeshDefects buildFromPolygons(const ObjPolygons& polygons, LoadProgress* progress = nullptr); //indices must be in range
+
+    //binary snapshot of every array (see hedsformat.h). Loading maps the file,
+    //copies the arrays out and validates them, nothing is parsed or re-matched
+    bool saveHEDS(const std::string& filePath) const;
+    bool loadHEDS(const std::string& filePath, LoadProgress* progress = nullptr); //false leaves the mesh empty
+
+    //topology operations. Each one reserves room for its output up front using
+    //the sizes below, so no array is reallocated halfway through
+    MeshIndex splitEdge(MeshIndex he); //returns the new midpoint vertex
+    void triangulateFace(MeshIndex f);
+    void subdivideFaces(const std::vector<MeshIndex>& faces); //Catmull-Clark on just these faces, see below
+    void catmullClarkSubdivide(); //rebuilds every array, see CatmullClark
+    bool loopSubdivide(); //likewise, see LoopSubdivision; false (and unchanged) unless all triangles
+
+    static MeshSizes splitEdgeGrowth() { return {1, 0, 2}; } //elements added by splitEdge
+    MeshSizes triangulateFaceGrowth(MeshIndex f) const; //elements added by triangulateFace
+
+    int countEdgesInFace(MeshIndex f) const;
+
+    static glm::vec3 randomColor(); //random face color
+
+private:
+    friend class CatmullClark; //write the fine mesh's arrays in parallel
+    friend class LoopSubdivision;
+
+    TwinLayout layout;
+
+    //vertex data
+    std::vector<glm::vec3> positions;
+    std::vector<MeshIndex> vertEdges;
+
+    //face data
+    std::vector<MeshIndex> faceEdges;
+    std::vector<glm::vec3> faceColors;
+
+    //half-edge data
+    std::vector<MeshIndex> heNext;
+    std::vector<MeshIndex> heSym; //empty in the Paired layout
+    std::vector<MeshIndex> heFace;
+    std::vector<MeshIndex> heVert;
+
+    MeshDefects matchTwins(); //set heSym from the HEs' end verts
+    void linkBoundaryLoops(); //give every unpaired HE a boundary sym
+    bool checkConnectivity(std::string& error) const; //every index in range, syms pair up
+    MeshIndex splitEdgePaired(MeshIndex he);
+};
+
+#endif // HALFEDGEMESH_H
@@ -0,0 +1,76 @@
+#include "hedsformat.h"
+#include "parallel.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t mix(uint64_t h, uint64_t word) {
+    return rotl(h ^ (word * PRIME2), 31) * PRIME1;
+}
+
+uint64_t hashBlock(const unsigned char* p, std::size_t size) {
+    uint64_t h = PRIME1 ^ size;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = mix(h, word);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + i, size - i);
+    return mix(h, tail);
+}
+
+} // namespace
+
+std::array<HedsSection, HEDS_NUM_SECTIONS> hedsSections(const HedsHeader& header) {
+    const uint64_t vec3Size = 3 * sizeof(float);
+    const uint64_t indexSize = sizeof(uint32_t);
+    const uint64_t numSyms = header.twinLayout == 0 ? header.numHalfEdges : 0;
+
+    std::array<uint64_t, HEDS_NUM_SECTIONS> sizes;
+    sizes[HEDS_POSITIONS] = header.numVertices * vec3Size;
+    sizes[HEDS_VERT_EDGES] = header.numVertices * indexSize;
+    sizes[HEDS_FACE_EDGES] = header.numFaces * indexSize;
+    sizes[HEDS_FACE_COLORS] = header.numFaces * vec3Size;
+    sizes[HEDS_NEXT] = header.numHalfEdges * indexSize;
+    sizes[HEDS_SYM] = numSyms * indexSize;
+    sizes[HEDS_FACE] = header.numHalfEdges * indexSize;
+    sizes[HEDS_VERT] = header.numHalfEdges * indexSize;
+
+    std::array<HedsSection, HEDS_NUM_SECTIONS> sections;
+    uint64_t offset = sizeof(HedsHeader);
+    for (int s = 0; s < HEDS_NUM_SECTIONS; ++s) {
+        sections[s] = {offset, sizes[s]};
+        offset += sizes[s];
+    }
+    return sections;
+}
+
+uint64_t hedsChecksum(uint64_t seed, const void* data, std::size_t size) {
+    const std::size_t blockSize = 1 << 20;
+    const std::size_t numBlocks = (size + blockSize - 1) / blockSize;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    std::vector<uint64_t> blockHashes(numBlocks);
+    parallelFor(0, numBlocks, 4, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t b = begin; b < end; ++b) {
+            std::size_t first = b * blockSize;
+            blockHashes[b] = hashBlock(bytes + first, std::min(blockSize, size - first));
+        }
+    });
+
+    uint64_t h = mix(seed, size);
+    for (uint64_t blockHash : blockHashes) {
+        h = mix(h, blockHash);
+    }
+    return h;
+}
@@ -0,0 +1,58 @@
+#ifndef HEDSFORMAT_H
+#define HEDSFORMAT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// On-disk layout of a .heds file, a binary snapshot of a HalfEdgeMesh's arrays.
+// The file is a HedsHeader followed by the sections below, back to back and in
+// enum order, each one the raw bytes of the matching kernel array. Values are
+// stored in the writer's byte order; byteOrder rejects files from the other one.
+// The checksum covers every section, not the header.
+
+constexpr char HEDS_MAGIC[4] = {'H', 'E', 'D', 'S'};
+constexpr uint32_t HEDS_VERSION = 1;
+constexpr uint32_t HEDS_BYTE_ORDER = 0x01020304u;
+
+struct HedsHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t twinLayout; //0 Explicit, 1 Paired
+    uint32_t numVertices;
+    uint32_t numFaces;
+    uint32_t numHalfEdges;
+    uint32_t reserved; //0
+    uint64_t payloadSize; //bytes of all sections together
+    uint64_t checksum;
+};
+static_assert(sizeof(HedsHeader) == 48, "HedsHeader is written as is");
+
+enum HedsSectionId {
+    HEDS_POSITIONS,   //numVertices glm::vec3
+    HEDS_VERT_EDGES,  //numVertices MeshIndex
+    HEDS_FACE_EDGES,  //numFaces MeshIndex
+    HEDS_FACE_COLORS, //numFaces glm::vec3
+    HEDS_NEXT,        //numHalfEdges MeshIndex
+    HEDS_SYM,         //numHalfEdges MeshIndex, empty in the Paired layout
+    HEDS_FACE,        //numHalfEdges MeshIndex
+    HEDS_VERT,        //numHalfEdges MeshIndex
+    HEDS_NUM_SECTIONS
+};
+
+// byte range of one section, offset from the start of the file
+struct HedsSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+std::array<HedsSection, HEDS_NUM_SECTIONS> hedsSections(const HedsHeader& header);
+
+// 64-bit hash of [data, data + size) chained onto seed. Fixed 1 MB blocks are
+// hashed in parallel and their hashes folded in order, so the result doesn't
+// depend on the thread count. Meant to catch truncation and corruption, not
+// tampering.
+uint64_t hedsChecksum(uint64_t seed, const void* data, std::size_t size);
+
+#endif // HEDSFORMAT_H
@@ -0,0 +1,947 @@
+#include "limitevaluator.h"
+#include "bsplinepatch.h"
+#include "catmullclark.h"
+#include "circulators.h"
+#include "objparser.h"
+#include "parallel.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+using Sample = LimitEvaluator::Sample;
+
+//(vert, face) for every face around a pinched vert, sorted by vert. A pinched
+//vert's fan misses its other fans, so its faces are looked up here instead
+using PinchedFaces = std::vector<std::pair<MeshIndex, MeshIndex>>;
+
+PinchedFaces findPinchedFaces(const HalfEdgeMesh& mesh, const std::vector<uint8_t>& pinched) {
+    PinchedFaces faces;
+    for (MeshIndex he = 0; he < mesh.numHalfEdges(); ++he) {
+        if (pinched[mesh.vert(he)] && !mesh.isBoundary(he)) faces.push_back({mesh.vert(he), mesh.face(he)});
+    }
+    std::sort(faces.begin(), faces.end());
+    return faces;
+}
+
+//a location waiting in a face, at (u, v) of that face
+struct Pending {
+    std::size_t index;
+    glm::vec2 uv;
+};
+
+//how a face's (u, v) maps to the parameters its locations were given in:
+//origin + u axisU + v axisV
+struct Frame {
+    glm::vec2 origin{0.0f};
+    glm::vec2 axisU{1.0f, 0.0f};
+    glm::vec2 axisV{0.0f, 1.0f};
+};
+
+//in a quad's (u, v), corner j is the head of HE j
+const glm::vec2 quadCorners[4] = {{1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}, {0.0f, 0.0f}};
+
+//child j of a quad in the quad's (u, v): it spans from the middle of HE j (its
+//(0, 0)) to corner j (its (1, 0)) and the centroid (its (0, 1))
+Frame quadChild(int j) {
+    Frame child;
+    child.origin = 0.5f * (quadCorners[(j + 3) % 4] + quadCorners[j]);
+    child.axisU = quadCorners[j] - child.origin;
+    child.axisV = glm::vec2(0.5f) - child.origin;
+    return child;
+}
+
+//inner, given in outer's face, in the parameters outer is given in
+Frame compose(const Frame& outer, const Frame& inner) {
+    Frame frame;
+    frame.origin = outer.origin + inner.origin.x * outer.axisU + inner.origin.y * outer.axisV;
+    frame.axisU = inner.axisU.x * outer.axisU + inner.axisU.y * outer.axisV;
+    frame.axisV = inner.axisV.x * outer.axisU + inner.axisV.y * outer.axisV;
+    return frame;
+}
+
+//uv, given in the parameters frame is given in, in frame's own (u, v)
+glm::vec2 toLocal(const Frame& frame, const glm::vec2& uv) {
+    const glm::vec2& a = frame.axisU;
+    const glm::vec2& b = frame.axisV;
+    const float det = a.x * b.y - a.y * b.x;
+    const glm::vec2 d = uv - frame.origin;
+    return glm::vec2(d.x * b.y - d.y * b.x, a.x * d.y - a.y * d.x) / det;
+}
+
+//turn derivatives along a face's own (u, v) into derivatives along the frame's
+//parameters, and fill in the normal
+Sample toFrame(const Frame& frame, const glm::vec3& position, const glm::vec3& du, const glm::vec3& dv) {
+    const glm::vec2& a = frame.axisU;
+    const glm::vec2& b = frame.axisV;
+    const float det = a.x * b.y - a.y * b.x;
+
+    Sample sample;
+    sample.position = position;
+    sample.tangentU = (b.y * du - a.y * dv) / det;
+    sample.tangentV = (a.x * dv - b.x * du) / det;
+    sample.normal = glm::normalize(glm::cross(sample.tangentU, sample.tangentV));
+    return sample;
+}
+
+//valences up to this get their tables made once, a vert with more gets its
+//tangent mask made on the spot and is refined around instead of Stam's patch
+const int maxTabulatedValence = 32;
+
+//the limit tangent mask of an interior vert of valence n, from its first
+//neighbour e_0: sum_i A_n cos(2 pi i / n) e_i + (cos(2 pi i / n) + cos(2 pi (i + 1) / n)) f_i
+//with f_i the diagonal between e_i and e_(i + 1), scaled by 1 / 12 so that at
+//valence 4 it's the B-spline's derivative
+struct TangentMask {
+    std::vector<float> edge;
+    std::vector<float> face;
+
+    TangentMask() = default;
+    explicit TangentMask(int n) : edge(n), face(n) {
+        const double pi = 3.14159265358979323846;
+        const double cosine = std::cos(2.0 * pi / n);
+        const double edgeWeight = 1.0 + cosine + std::cos(pi / n) * std::sqrt(2.0 * (9.0 + cosine));
+        for (int i = 0; i < n; ++i) {
+            const double here = std::cos(2.0 * pi * i / n);
+            const double after = std::cos(2.0 * pi * (i + 1) / n);
+            edge[i] = static_cast<float>(edgeWeight * here / 12.0);
+            face[i] = static_cast<float>((here + after) / 12.0);
+        }
+    }
+};
+
+const std::vector<TangentMask> tangentMasks = [] {
+    std::vector<TangentMask> masks(maxTabulatedValence + 1);
+    for (int n = 3; n <= maxTabulatedValence; ++n) {
+        masks[n] = TangentMask(n);
+    }
+    return masks;
+}();
+
+//v's limit position, and its limit tangents towards the tails of towardA and
+//towardB (two of the HEs pointing at v), per unit of a parameter running along
+//that edge. Inside, a tangent is the tangent mask starting from the neighbour
+//it points to. On a boundary where v has two quads it's the B-spline's derivative
+//with the boundary reflected, which refines by the same rules as the boundary.
+//Returns false for a pinched vert, a vert with any other face than a quad
+//around it, an interior vert with fewer than three and a boundary vert with
+//other than two
+bool cornerLimit(const HalfEdgeMesh& mesh, const std::vector<uint8_t>& pinched, MeshIndex v, MeshIndex towardA,
+                 MeshIndex towardB, glm::vec3& position, glm::vec3& tangentA, glm::vec3& tangentB) {
+    if (pinched[v]) return false;
+    int valence = 0;
+    MeshIndex boundary = NO_INDEX;
+    for (MeshIndex he : vertexHalfEdges(mesh, v)) {
+        if (mesh.isBoundary(he)) {
+            boundary = he;
+        } else if (mesh.countEdgesInFace(mesh.face(he)) != 4) {
+            return false;
+        }
+        ++valence;
+    }
+    if (boundary != NO_INDEX ? valence != 3 : valence < 3) return false;
+    position = limitPosition(mesh, v);
+
+    if (boundary != NO_INDEX) {
+        // a and b along the boundary, c across from v with ac and bc the
+        // diagonals next to a and b
+        const MeshIndex toB = mesh.sym(mesh.next(boundary));
+        const MeshIndex toC = mesh.sym(mesh.next(toB));
+        const glm::vec3& a = mesh.position(mesh.vert(mesh.sym(boundary)));
+        const glm::vec3& b = mesh.position(mesh.vert(mesh.sym(toB)));
+        const glm::vec3& c = mesh.position(mesh.vert(mesh.sym(toC)));
+        const glm::vec3& bc = mesh.position(mesh.vert(mesh.next(mesh.next(toB))));
+        const glm::vec3& ac = mesh.position(mesh.vert(mesh.next(mesh.next(toC))));
+        auto tangent = [&](MeshIndex toward) {
+            if (toward == boundary) return 0.5f * (a - b);
+            if (toward == toB) return 0.5f * (b - a);
+            return ((ac - a) + 4.0f * (c - mesh.position(v)) + (bc - b)) / 6.0f;
+        };
+        tangentA = tangent(towardA);
+        tangentB = tangent(towardB);
+        return true;
+    }
+
+    const TangentMask computed = valence < static_cast<int>(tangentMasks.size()) ? TangentMask() : TangentMask(valence);
+    const TangentMask& mask = valence < static_cast<int>(tangentMasks.size()) ? tangentMasks[valence] : computed;
+    auto tangent = [&](MeshIndex toward) {
+        glm::vec3 sum(0.0f);
+        MeshIndex he = toward;
+        int i = 0;
+        do {
+            sum += mask.edge[i] * mesh.position(mesh.vert(mesh.sym(he)));
+            sum += mask.face[i] * mesh.position(mesh.vert(mesh.next(mesh.next(he))));
+            he = mesh.sym(mesh.next(he));
+            ++i;
+        } while (he != toward);
+        return sum;
+    };
+    tangentA = tangent(towardA);
+    tangentB = tangent(towardB);
+    return true;
+}
+
+//a query right on one of quad f's corners, from cornerLimit. Returns false for
+//any other uv, and for a corner cornerLimit has no closed form for
+bool evaluateCorner(const HalfEdgeMesh& mesh, const std::vector<uint8_t>& pinched, MeshIndex f, const Frame& frame,
+                    const glm::vec2& uv, Sample& sample) {
+    if ((uv.x != 0.0f && uv.x != 1.0f) || (uv.y != 0.0f && uv.y != 1.0f)) return false;
+    MeshIndex e[4];
+    e[0] = mesh.faceEdge(f);
+    for (int k = 1; k < 4; ++k) {
+        e[k] = mesh.next(e[k - 1]);
+    }
+
+    // the HEs pointing at the corner along u and along v, and which way u and v
+    // run along them
+    const int corner = uv.y == 0.0f ? (uv.x == 0.0f ? 0 : 1) : (uv.x == 0.0f ? 3 : 2);
+    const struct {
+        MeshIndex alongU;
+        float signU;
+        MeshIndex alongV;
+        float signV;
+    } edges[4] = {{mesh.sym(e[0]), 1.0f, e[3], 1.0f},
+                  {e[0], -1.0f, mesh.sym(e[1]), 1.0f},
+                  {mesh.sym(e[2]), -1.0f, e[1], -1.0f},
+                  {e[2], 1.0f, mesh.sym(e[3]), -1.0f}};
+    glm::vec3 position, du, dv;
+    if (!cornerLimit(mesh, pinched, mesh.vert(e[(corner + 3) % 4]), edges[corner].alongU, edges[corner].alongV,
+                     position, du, dv)) {
+        return false;
+    }
+    sample = toFrame(frame, position, edges[corner].signU * du, edges[corner].signV * dv);
+    return true;
+}
+
+//the interior valence of v when every face around it is a quad, else 0
+int quadValence(const HalfEdgeMesh& mesh, MeshIndex v) {
+    int valence = 0;
+    for (MeshIndex he : vertexHalfEdges(mesh, v)) {
+        if (mesh.isBoundary(he) || mesh.countEdgesInFace(mesh.face(he)) != 4) return 0;
+        ++valence;
+    }
+    return valence;
+}
+
+//Catmull-Clark around an extraordinary vert of valence n, in Stam's names for the
+//points. Sector i is the quad between spokes i and i + 1 and has its own grid
+//(a, b): the vert at (0, 0), spoke i along a and spoke i + 1 along b, so (0, b)
+//of sector i is (b, 0) of sector i + 1. A point past a sector's sides is named
+//in the sector next to it: (a, -b) of sector i is (b, a) of sector i - 1, and
+//(-a, b) is (b, a) of sector i + 1. The ring is the 2n + 8 points a quad of
+//sector 0 needs one level down: the vert, the spokes, the diagonals of the
+//quads around the vert, and (2, 0), (2, 1), (2, 2), (1, 2), (0, 2), (2, -1),
+//(-1, 2) of sector 0
+class SectorGrid {
+public:
+    explicit SectorGrid(int valence) : n(valence) {
+        ring.push_back({0, 0, 0});
+        for (int i = 0; i < n; ++i) {
+            ring.push_back({i, 1, 0});
+        }
+        for (int i = 0; i < n; ++i) {
+            ring.push_back({i, 1, 1});
+        }
+        const int extra[7][2] = {{2, 0}, {2, 1}, {2, 2}, {1, 2}, {0, 2}, {2, -1}, {-1, 2}};
+        for (const auto& point : extra) {
+            ring.push_back(canonical(0, point[0], point[1]));
+        }
+    }
+
+    int ringSize() const { return static_cast<int>(ring.size()); }
+
+    //the weights of the ring in its own point r one level finer
+    std::vector<double> refinedRingPoint(int r) const {
+        return refined(ring[r][0], ring[r][1], ring[r][2]);
+    }
+
+    //the weights of the ring in point (a, b) of sector i one level finer
+    std::vector<double> refined(int sector, int a, int b) const {
+        std::vector<double> weights(ring.size(), 0.0);
+        const Point point = canonical(sector, a, b);
+        sector = point[0];
+        a = point[1];
+        b = point[2];
+        if (a == 0) {
+            // the vert itself
+            const double n2 = static_cast<double>(n) * n;
+            weights[0] += (n - 2.0) / n;
+            for (int i = 0; i < n; ++i) {
+                add(weights, i, 1, 0, 1.0 / n2);
+                addCentroid(weights, i, 0, 0, 1.0 / n2);
+            }
+        } else if (a % 2 == 0 && b % 2 == 0) {
+            const int x = a / 2;
+            const int y = b / 2;
+            add(weights, sector, x, y, 0.5);
+            add(weights, sector, x - 1, y, 1.0 / 16.0);
+            add(weights, sector, x + 1, y, 1.0 / 16.0);
+            add(weights, sector, x, y - 1, 1.0 / 16.0);
+            add(weights, sector, x, y + 1, 1.0 / 16.0);
+            addCentroid(weights, sector, x - 1, y - 1, 1.0 / 16.0);
+            addCentroid(weights, sector, x, y - 1, 1.0 / 16.0);
+            addCentroid(weights, sector, x - 1, y, 1.0 / 16.0);
+            addCentroid(weights, sector, x, y, 1.0 / 16.0);
+        } else if (b % 2 == 0) {
+            const int x = (a - 1) / 2;
+            const int y = b / 2;
+            add(weights, sector, x, y, 0.25);
+            add(weights, sector, x + 1, y, 0.25);
+            addCentroid(weights, sector, x, y, 0.25);
+            addCentroid(weights, sector, x, y - 1, 0.25);
+        } else if (a % 2 == 0) {
+            const int x = a / 2;
+            const int y = (b - 1) / 2;
+            add(weights, sector, x, y, 0.25);
+            add(weights, sector, x, y + 1, 0.25);
+            addCentroid(weights, sector, x, y, 0.25);
+            addCentroid(weights, sector, x - 1, y, 0.25);
+        } else {
+            addCentroid(weights, sector, (a - 1) / 2, (b - 1) / 2, 1.0);
+        }
+        return weights;
+    }
+
+private:
+    using Point = std::array<int, 3>; //sector, a, b
+
+    int n;
+    std::vector<Point> ring;
+
+    //the point's name in the one sector where a >= 1 and b >= 0, or (0, 0, 0)
+    Point canonical(int sector, int a, int b) const {
+        assert(a >= 0 || b >= 0);
+        while (true) {
+            sector = (sector % n + n) % n;
+            if (a == 0 && b == 0) return {0, 0, 0};
+            if (b < 0) {
+                const int oldA = a;
+                sector -= 1;
+                a = -b;
+                b = oldA;
+            } else if (a < 0) {
+                const int oldA = a;
+                sector += 1;
+                a = b;
+                b = -oldA;
+            } else if (a == 0) {
+                sector += 1;
+                a = b;
+                b = 0;
+            } else {
+                return {sector, a, b};
+            }
+        }
+    }
+
+    void add(std::vector<double>& weights, int sector, int a, int b, double weight) const {
+        const auto it = std::find(ring.begin(), ring.end(), canonical(sector, a, b));
+        assert(it != ring.end());
+        weights[it - ring.begin()] += weight;
+    }
+
+    //the face point of the quad with (a, b) at its lowest corner
+    void addCentroid(std::vector<double>& weights, int sector, int a, int b, double weight) const {
+        add(weights, sector, a, b, 0.25 * weight);
+        add(weights, sector, a + 1, b, 0.25 * weight);
+        add(weights, sector, a + 1, b + 1, 0.25 * weight);
+        add(weights, sector, a, b + 1, 0.25 * weight);
+    }
+};
+
+//Stam's evaluation of a quad whose one extraordinary corner has valence n.
+//A query at about 2^-k from the corner lands, after k levels, in one of three
+//regular sub-patches next to the corner's quad, and that sub-patch's 16
+//control points are a fixed linear map B A^(k - 1) of the ring. Stam takes A
+//apart into eigenvectors so that any k costs the same; here the maps for k up
+//to maxLevels are multiplied out once per valence instead, which needs no
+//eigensolver, and a query closer than 2^-maxLevels is answered at the corner
+class ExtraordinaryPatch {
+public:
+    static const int maxLevels = 40; //the slowest-shrinking ring halves in size every 1.6 levels
+
+    ExtraordinaryPatch() = default;
+    explicit ExtraordinaryPatch(int valence) {
+        const SectorGrid grid(valence);
+        ringSize = grid.ringSize();
+        const std::size_t numPoints = static_cast<std::size_t>(ringSize);
+
+        // A makes the ring one level finer, B[k] picks sub-patch k out of the
+        // finer points: the quads at (1, 0), (1, 1) and (0, 1) of sector 0
+        std::vector<double> A(numPoints * numPoints);
+        for (std::size_t r = 0; r < numPoints; ++r) {
+            const std::vector<double> row = grid.refinedRingPoint(static_cast<int>(r));
+            std::copy(row.begin(), row.end(), A.begin() + r * numPoints);
+        }
+        const int cells[3][2] = {{1, 0}, {1, 1}, {0, 1}};
+        std::vector<double> B(3 * 16 * numPoints);
+        for (int k = 0; k < 3; ++k) {
+            for (int j = 0; j < 4; ++j) {
+                for (int i = 0; i < 4; ++i) {
+                    const std::vector<double> row = grid.refined(0, cells[k][0] - 1 + i, cells[k][1] - 1 + j);
+                    std::copy(row.begin(), row.end(), B.begin() + (16 * k + 4 * j + i) * numPoints);
+                }
+            }
+        }
+
+        std::vector<double> power(numPoints * numPoints, 0.0); //A^(level - 1)
+        for (std::size_t r = 0; r < numPoints; ++r) {
+            power[r * numPoints + r] = 1.0;
+        }
+        std::vector<double> product(numPoints * numPoints);
+        weights.resize(maxLevels * 3 * 16 * numPoints);
+        for (int level = 1; level <= maxLevels; ++level) {
+            double* out = weights.data() + (level - 1) * 3 * 16 * numPoints;
+            for (std::size_t row = 0; row < 3 * 16; ++row) {
+                for (std::size_t c = 0; c < numPoints; ++c) {
+                    double sum = 0.0;
+                    for (std::size_t m = 0; m < numPoints; ++m) {
+                        sum += B[row * numPoints + m] * power[m * numPoints + c];
+                    }
+                    out[row * numPoints + c] = sum;
+                }
+            }
+            for (std::size_t r = 0; r < numPoints; ++r) {
+                for (std::size_t c = 0; c < numPoints; ++c) {
+                    double sum = 0.0;
+                    for (std::size_t m = 0; m < numPoints; ++m) {
+                        sum += A[r * numPoints + m] * power[m * numPoints + c];
+                    }
+                    product[r * numPoints + c] = sum;
+                }
+            }
+            power.swap(product);
+        }
+    }
+
+    bool empty() const { return weights.empty(); }
+
+    //the patch at (u, v) of sector 0, with the corner at (0, 0), over the ring's
+    //positions. Returns false for a (u, v) closer to the corner than maxLevels reach
+    bool evaluate(const glm::vec3* ring, float u, float v, PatchSample& sample) const {
+        int exponent = 0;
+        std::frexp(std::max(u, v), &exponent);
+        const int level = std::max(1, 1 - exponent);
+        if (level > maxLevels) return false;
+
+        float s = std::ldexp(u, level);
+        float t = std::ldexp(v, level);
+        int subPatch = 2;
+        if (s >= 1.0f) {
+            subPatch = t >= 1.0f ? 1 : 0;
+            s -= 1.0f;
+        }
+        if (t >= 1.0f) t -= 1.0f;
+
+        // the maps' rows add up to 1, so they're applied to the ring around its
+        // vert: deep down the control points are much closer together than the
+        // ring is to the origin, and floats would lose their differences
+        const std::size_t numPoints = static_cast<std::size_t>(ringSize);
+        const double* map = weights.data() + ((level - 1) * 3 + subPatch) * 16 * numPoints;
+        glm::vec3 controlPoints[16];
+        for (std::size_t k = 0; k < 16; ++k) {
+            glm::dvec3 sum(0.0);
+            for (std::size_t c = 1; c < numPoints; ++c) {
+                sum += map[k * numPoints + c] * glm::dvec3(ring[c] - ring[0]);
+            }
+            controlPoints[k] = glm::vec3(sum);
+        }
+        sample = evaluatePatch(controlPoints, s, t);
+        sample.position += ring[0];
+        const float scale = std::ldexp(1.0f, level);
+        sample.tangentU *= scale;
+        sample.tangentV *= scale;
+        return true;
+    }
+
+private:
+    int ringSize = 0;
+    std::vector<double> weights; //[level - 1][sub-patch][16][ring point]
+};
+
+//the ring around quad f's extraordinary corner, in SectorGrid's order with
+//spoke 0 at the head of f's HE leaving the corner, and that corner (the tail of
+//f's HE of the same index). Returns -1 unless f's other three corners are
+//regular, the extraordinary one is inside with only quads around it, and none
+//of the ring is pinched
+int gatherExtraordinaryRing(const HalfEdgeMesh& mesh, const std::vector<uint8_t>& pinched, MeshIndex f,
+                            std::vector<MeshIndex>& ring) {
+    MeshIndex e[4];
+    e[0] = mesh.faceEdge(f);
+    for (int k = 1; k < 4; ++k) {
+        e[k] = mesh.next(e[k - 1]);
+    }
+    if (mesh.next(e[3]) != e[0]) return -1;
+
+    int corner = -1;
+    int valence = 0;
+    for (int k = 0; k < 4; ++k) {
+        const int cornerValence = quadValence(mesh, mesh.vert(e[(k + 3) % 4]));
+        if (cornerValence == 0) return -1;
+        if (cornerValence == 4) continue;
+        if (corner >= 0) return -1;
+        corner = k;
+        valence = cornerValence;
+    }
+    if (corner < 0) return -1;
+
+    // round the corner: every HE leaving it, its head a spoke and the next
+    // corner of its face a diagonal. Then out from the quad's far corner
+    // (1, 1) along the quads past spoke 0 and spoke 1
+    ring.resize(2 * valence + 8);
+    ring[0] = mesh.vert(e[(corner + 3) % 4]);
+    MeshIndex out = e[corner];
+    for (int i = 0; i < valence; ++i) {
+        ring[1 + i] = mesh.vert(out);
+        ring[1 + valence + i] = mesh.vert(mesh.next(out));
+        out = mesh.sym(mesh.next(mesh.next(mesh.next(out))));
+    }
+    const MeshIndex x = mesh.next(mesh.sym(mesh.next(e[corner]))); //(1, 0) -> (2, 0)
+    const MeshIndex y = mesh.sym(mesh.next(mesh.next(x)));          //(1, 1) -> (2, 1)
+    const MeshIndex z = mesh.next(mesh.sym(mesh.next(mesh.next(mesh.next(y))))); //(1, 2) -> (0, 2)
+    MeshIndex* extra = ring.data() + 2 * valence + 1;
+    extra[0] = mesh.vert(x);
+    extra[1] = mesh.vert(mesh.next(x));
+    extra[2] = mesh.vert(mesh.next(y));
+    extra[3] = mesh.vert(mesh.next(mesh.next(y)));
+    extra[4] = mesh.vert(z);
+    extra[5] = mesh.vert(mesh.next(mesh.next(mesh.sym(x))));
+    extra[6] = mesh.vert(mesh.next(mesh.sym(mesh.next(z))));
+
+    for (MeshIndex v : ring) {
+        if (pinched[v]) return -1;
+    }
+    return corner;
+}
+
+//one face's neighbourhood refined by refineAround, and its children's once a
+//query needs them
+struct Refinement {
+    HalfEdgeMesh mesh{TwinLayout::Paired}; //the face's child quads are faces [0, sides)
+    std::vector<uint8_t> pinched;
+    PinchedFaces pinchedFaces;
+    std::vector<std::unique_ptr<Refinement>> children; //[j] around child quad j
+};
+
+//cut f and the faces around its corners out of mesh and subdivide them, so f's
+//child quads are fine's faces [0, sides of f) and every vert they and the faces
+//around their own corners use is where full refinement would put it. That's all
+//a child reads, whether it's evaluated or refined around in turn
+std::unique_ptr<Refinement> refineAround(const HalfEdgeMesh& mesh, const std::vector<uint8_t>& pinched,
+                                         const PinchedFaces& pinchedFaces, MeshIndex f) {
+    // every face around each of f's corners, from all the fans of a pinched one
+    std::vector<MeshIndex> faces;
+    for (MeshIndex corner : faceVertices(mesh, f)) {
+        if (!pinched[corner]) {
+            for (MeshIndex face : vertexFaces(mesh, corner)) faces.push_back(face);
+            continue;
+        }
+        auto it = std::lower_bound(pinchedFaces.begin(), pinchedFaces.end(), std::make_pair(corner, MeshIndex(0)));
+        for (; it != pinchedFaces.end() && it->first == corner; ++it) faces.push_back(it->second);
+    }
+    std::sort(faces.begin(), faces.end());
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+    std::iter_swap(faces.begin(), std::lower_bound(faces.begin(), faces.end(), f));
+
+    ObjPolygons region;
+    std::unordered_map<MeshIndex, MeshIndex> regionVerts;
+    for (MeshIndex face : faces) {
+        for (MeshIndex corner : faceVertices(mesh, face)) {
+            auto [it, added] = regionVerts.try_emplace(corner, static_cast<MeshIndex>(region.positions.size()));
+            if (added) region.positions.push_back(mesh.position(corner));
+            region.cornerVerts.push_back(it->second);
+        }
+        region.faceOffsets.push_back(static_cast<MeshIndex>(region.cornerVerts.size()));
+    }
+
+    HalfEdgeMesh submesh(TwinLayout::Paired);
+    submesh.buildFromPolygons(region);
+
+    // every vert keeps the HE it has in mesh, so a pinched vert is refined with
+    // the same fan. A submesh face starts on the HE ending at its first corner
+    for (MeshIndex k = 0; k < submesh.numFaces(); ++k) {
+        FaceHalfEdges::iterator he = faceHalfEdges(mesh, faces[k]).begin();
+        for (MeshIndex local : faceHalfEdges(submesh, k)) {
+            if (mesh.vertexEdge(mesh.vert(*he)) == *he) submesh.setVertex(local, submesh.vert(local));
+            ++he;
+        }
+    }
+
+    std::unique_ptr<Refinement> refinement = std::make_unique<Refinement>();
+    CatmullClark::subdivide(submesh, refinement->mesh);
+    refinement->pinched = findPinchedVerts(refinement->mesh);
+    refinement->pinchedFaces = findPinchedFaces(refinement->mesh, refinement->pinched);
+    refinement->children.resize(mesh.countEdgesInFace(f));
+    return refinement;
+}
+
+//the quad's corners pushed to the limit and interpolated bilinearly: once the
+//quad is small enough, as close to the limit surface as a float gets
+void interpolateLimitQuad(const HalfEdgeMesh& mesh, MeshIndex f, const Frame& frame,
+                          const std::vector<Pending>& pending, Sample* samples) {
+    const MeshIndex e0 = mesh.faceEdge(f);
+    const MeshIndex e1 = mesh.next(e0);
+    const MeshIndex e2 = mesh.next(e1);
+    const glm::vec3 p00 = limitPosition(mesh, mesh.vert(mesh.next(e2)));
+    const glm::vec3 p10 = limitPosition(mesh, mesh.vert(e0));
+    const glm::vec3 p11 = limitPosition(mesh, mesh.vert(e1));
+    const glm::vec3 p01 = limitPosition(mesh, mesh.vert(e2));
+
+    for (const Pending& query : pending) {
+        const float u = query.uv.x;
+        const float v = query.uv.y;
+        const glm::vec3 position = (1 - u) * (1 - v) * p00 + u * (1 - v) * p10 + u * v * p11 + (1 - u) * v * p01;
+        const glm::vec3 du = (1 - v) * (p10 - p00) + v * (p11 - p01);
+        const glm::vec3 dv = (1 - u) * (p01 - p00) + u * (p11 - p10);
+        samples[query.index] = toFrame(frame, position, du, dv);
+    }
+}
+
+//evaluate every pending location in quad f of mesh: in closed form where the
+//class comment says there is one, else by refining around f (once, into
+//refinement) and moving into f's children. A quad's child j sits around the
+//head of its j-th HE
+void descend(const std::vector<ExtraordinaryPatch>& patches, const HalfEdgeMesh& mesh,
+             const std::vector<uint8_t>& pinched, const PinchedFaces& pinchedFaces, MeshIndex f,
+             const Frame& frame, std::vector<Pending>& pending, int levelsLeft,
+             std::unique_ptr<Refinement>& refinement, Sample* samples) {
+    MeshIndex grid[16];
+    if (gatherRegularPatch(mesh, pinched, f, grid)) {
+        glm::vec3 controlPoints[16];
+        for (int k = 0; k < 16; ++k) {
+            controlPoints[k] = mesh.position(grid[k]);
+        }
+        for (const Pending& query : pending) {
+            const PatchSample patch = evaluatePatch(controlPoints, query.uv.x, query.uv.y);
+            samples[query.index] = toFrame(frame, patch.position, patch.tangentU, patch.tangentV);
+        }
+        return;
+    }
+
+    std::size_t open = 0;
+    for (std::size_t k = 0; k < pending.size(); ++k) {
+        const Pending query = pending[k];
+        if (!evaluateCorner(mesh, pinched, f, frame, query.uv, samples[query.index])) pending[open++] = query;
+    }
+    pending.resize(open);
+    if (pending.empty()) return;
+
+    std::vector<MeshIndex> ring;
+    const int corner = gatherExtraordinaryRing(mesh, pinched, f, ring);
+    const std::size_t valence = corner >= 0 ? (ring.size() - 8) / 2 : 0;
+    if (corner >= 0 && valence < patches.size() && !patches[valence].empty()) {
+        // sector 0 of the corner's grid runs along f's HE leaving the corner
+        const glm::vec2 cornerUV[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+        Frame sector;
+        sector.origin = cornerUV[corner];
+        sector.axisU = cornerUV[(corner + 1) % 4] - sector.origin;
+        sector.axisV = cornerUV[(corner + 3) % 4] - sector.origin;
+        const Frame sectorFrame = compose(frame, sector);
+
+        std::vector<glm::vec3> positions(ring.size());
+        for (std::size_t r = 0; r < ring.size(); ++r) {
+            positions[r] = mesh.position(ring[r]);
+        }
+        for (const Pending& query : pending) {
+            const glm::vec2 st = toLocal(sector, query.uv);
+            PatchSample patch;
+            if (patches[valence].evaluate(positions.data(), st.x, st.y, patch)) {
+                samples[query.index] = toFrame(sectorFrame, patch.position, patch.tangentU, patch.tangentV);
+            } else {
+                evaluateCorner(mesh, pinched, f, frame, sector.origin, samples[query.index]);
+            }
+        }
+        return;
+    }
+
+    if (levelsLeft == 0) {
+        interpolateLimitQuad(mesh, f, frame, pending, samples);
+        return;
+    }
+    if (!refinement) refinement = refineAround(mesh, pinched, pinchedFaces, f);
+
+    std::vector<Pending> childPending[4];
+    for (const Pending& query : pending) {
+        const bool right = query.uv.x >= 0.5f;
+        const bool top = query.uv.y >= 0.5f;
+        const int j = right ? (top ? 1 : 0) : (top ? 2 : 3);
+        childPending[j].push_back(query);
+    }
+
+    for (int j = 0; j < 4; ++j) {
+        if (childPending[j].empty()) continue;
+        const Frame local = quadChild(j);
+        for (Pending& query : childPending[j]) {
+            query.uv = toLocal(local, query.uv);
+        }
+        descend(patches, refinement->mesh, refinement->pinched, refinement->pinchedFaces, j, compose(frame, local),
+                childPending[j], levelsLeft - 1, refinement->children[j], samples);
+    }
+}
+
+} // namespace
+
+struct LimitEvaluator::Cache {
+    std::vector<uint8_t> pinched; //base verts that are never control points
+    PinchedFaces pinchedFaces;
+    std::vector<ExtraordinaryPatch> patches; //[valence], for the valences the base has
+
+    //base face f's refinement is in stripe f % 64, under that stripe's lock
+    struct Stripe {
+        std::mutex lock;
+        std::unordered_map<MeshIndex, std::unique_ptr<Refinement>> faces;
+    };
+    std::array<Stripe, 64> refined;
+};
+
+LimitEvaluator::LimitEvaluator(const HalfEdgeMesh& base, int maxLevels)
+    : base(base), maxLevels(std::max(maxLevels, 1)), cache(std::make_unique<Cache>()) {
+    cache->pinched = findPinchedVerts(base);
+    cache->pinchedFaces = findPinchedFaces(base, cache->pinched);
+
+    // a refined vert's valence is a base vert's, a base face's side count, or 4
+    std::vector<uint8_t> needed(maxTabulatedValence + 1, 0);
+    auto need = [&](std::ptrdiff_t valence) {
+        if (valence >= 3 && valence <= maxTabulatedValence && valence != 4) needed[valence] = 1;
+    };
+    for (MeshIndex v = 0; v < base.numVertices(); ++v) {
+        const VertexHalfEdges fan = vertexHalfEdges(base, v);
+        need(std::distance(fan.begin(), fan.end()));
+    }
+    for (MeshIndex f = 0; f < base.numFaces(); ++f) {
+        need(base.countEdgesInFace(f));
+    }
+    cache->patches.resize(maxTabulatedValence + 1);
+    parallelFor(0, needed.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t valence = begin; valence < end; ++valence) {
+            if (needed[valence]) cache->patches[valence] = ExtraordinaryPatch(static_cast<int>(valence));
+        }
+    });
+}
+
+LimitEvaluator::~LimitEvaluator() = default;
+
+LimitEvaluator::Sample LimitEvaluator::evaluate(const Location& location) const {
+    Sample sample;
+    const std::size_t order = 0;
+    evaluateFace(location.face, &location, &order, 1, &sample);
+    return sample;
+}
+
+void LimitEvaluator::evaluate(const std::vector<Location>& locations, std::vector<Sample>& samples) const {
+    samples.resize(locations.size());
+
+    // counting sort the locations by face, then every face with any is one task
+    std::vector<std::size_t> faceStart(base.numFaces() + 1, 0);
+    for (const Location& location : locations) {
+        ++faceStart[location.face + 1];
+    }
+    for (MeshIndex f = 0; f < base.numFaces(); ++f) {
+        faceStart[f + 1] += faceStart[f];
+    }
+    std::vector<std::size_t> order(locations.size());
+    std::vector<std::size_t> fill(faceStart.begin(), faceStart.end() - 1);
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        order[fill[locations[i].face]++] = i;
+    }
+    std::vector<MeshIndex> usedFaces;
+    for (MeshIndex f = 0; f < base.numFaces(); ++f) {
+        if (faceStart[f + 1] > faceStart[f]) usedFaces.push_back(f);
+    }
+
+    parallelFor(0, usedFaces.size(), 16, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; ++k) {
+            const MeshIndex f = usedFaces[k];
+            evaluateFace(f, locations.data(), order.data() + faceStart[f], faceStart[f + 1] - faceStart[f],
+                         samples.data());
+        }
+    });
+}
+
+//evaluate locations[order[0, count)], which are all on base face f
+void LimitEvaluator::evaluateFace(MeshIndex f, const Location* locations, const std::size_t* order, std::size_t count,
+                                  Sample* samples) const {
+    auto clampedUV = [&](std::size_t i) {
+        return glm::clamp(glm::vec2(locations[i].u, locations[i].v), 0.0f, 1.0f);
+    };
+
+    Cache::Stripe& stripe = cache->refined[f % cache->refined.size()];
+    std::lock_guard<std::mutex> lock(stripe.lock);
+    std::unique_ptr<Refinement>& refinement = stripe.faces[f];
+
+    const int numSides = base.countEdgesInFace(f);
+    if (numSides == 4) {
+        std::vector<Pending> pending(count);
+        for (std::size_t k = 0; k < count; ++k) {
+            pending[k] = {order[k], clampedUV(order[k])};
+        }
+        descend(cache->patches, base, cache->pinched, cache->pinchedFaces, f, Frame(), pending, maxLevels, refinement,
+                samples);
+        if (!refinement) stripe.faces.erase(f);
+        return;
+    }
+
+    // a non-quad's locations already name the child quad they're in
+    if (!refinement) refinement = refineAround(base, cache->pinched, cache->pinchedFaces, f);
+    std::vector<std::vector<Pending>> childPending(numSides);
+    for (std::size_t k = 0; k < count; ++k) {
+        const MeshIndex corner = std::min<MeshIndex>(locations[order[k]].corner, numSides - 1);
+        childPending[corner].push_back({order[k], clampedUV(order[k])});
+    }
+    for (int j = 0; j < numSides; ++j) {
+        if (childPending[j].empty()) continue;
+        descend(cache->patches, refinement->mesh, refinement->pinched, refinement->pinchedFaces, j, Frame(),
+                childPending[j], maxLevels - 1, refinement->children[j], samples);
+    }
+}
+
+void LimitEvaluator::refineOntoLimit(int levels, HalfEdgeMesh& fine, std::vector<glm::vec3>& normals) const {
+    CatmullClark::subdivide(base, fine);
+    HalfEdgeMesh coarse(TwinLayout::Paired);
+    for (int level = 1; level < levels; ++level) {
+        std::swap(coarse, fine);
+        CatmullClark::subdivide(coarse, fine);
+    }
+
+    // every fine face is a quad, so a fine vert has its limit in closed form
+    // unless it's pinched or on a boundary with other than two faces. The
+    // normal is the one of the quad in front of the vert's HE
+    const std::vector<uint8_t> finePinched = findPinchedVerts(fine);
+    std::vector<glm::vec3> positions(fine.positionData(), fine.positionData() + fine.numVertices());
+    std::vector<uint8_t> open(fine.numVertices(), 0);
+    normals.assign(fine.numVertices(), glm::vec3(0.0f));
+    parallelFor(0, fine.numVertices(), 1 << 12, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex v = static_cast<MeshIndex>(begin); v < end; ++v) {
+            MeshIndex in = fine.vertexEdge(v);
+            if (in == NO_INDEX) continue; //verts without faces stay where they are
+            if (fine.isBoundary(in)) in = fine.sym(fine.next(in));
+            glm::vec3 along, across;
+            if (cornerLimit(fine, finePinched, v, fine.sym(fine.next(in)), in, positions[v], along, across)) {
+                normals[v] = glm::normalize(glm::cross(along, across));
+            } else {
+                open[v] = 1;
+            }
+        }
+    });
+
+    // the rest are evaluated at their place in the base. Level 1 split each base
+    // face, in face order, into one quad around the head of each of its HEs,
+    // which for a non-quad are already the child quads its locations name, and
+    // every level after that split quad q into quads [4q, 4q + 4). A vert is
+    // corner k of the quad in front of its HE, so it's the head of that quad's
+    // k-th HE
+    std::vector<MeshIndex> openVerts;
+    for (MeshIndex v = 0; v < fine.numVertices(); ++v) {
+        if (open[v]) openVerts.push_back(v);
+    }
+    std::vector<MeshIndex> faceStart(base.numFaces() + 1, 0);
+    if (!openVerts.empty()) {
+        for (MeshIndex f = 0; f < base.numFaces(); ++f) {
+            faceStart[f + 1] = faceStart[f] + static_cast<MeshIndex>(base.countEdgesInFace(f));
+        }
+    }
+    std::vector<Location> locations(openVerts.size());
+    for (std::size_t i = 0; i < openVerts.size(); ++i) {
+        MeshIndex in = fine.vertexEdge(openVerts[i]);
+        if (fine.isBoundary(in)) in = fine.sym(fine.next(in));
+        MeshIndex quad = fine.face(in);
+        int k = 0;
+        for (MeshIndex he = fine.faceEdge(quad); he != in; he = fine.next(he)) ++k;
+
+        Frame place;
+        for (int level = levels; level > 1; --level) {
+            place = compose(quadChild(static_cast<int>(quad % 4)), place);
+            quad /= 4;
+        }
+        const MeshIndex f = static_cast<MeshIndex>(std::upper_bound(faceStart.begin(), faceStart.end(), quad)
+                                                   - faceStart.begin() - 1);
+        MeshIndex corner = quad - faceStart[f];
+        if (base.countEdgesInFace(f) == 4) {
+            place = compose(quadChild(static_cast<int>(corner)), place);
+            corner = 0;
+        }
+        const glm::vec2 uv = place.origin + quadCorners[k].x * place.axisU + quadCorners[k].y * place.axisV;
+        locations[i] = {f, corner, uv.x, uv.y};
+    }
+    std::vector<Sample> samples;
+    evaluate(locations, samples);
+    for (std::size_t i = 0; i < openVerts.size(); ++i) {
+        positions[openVerts[i]] = samples[i].position;
+        normals[openVerts[i]] = samples[i].normal;
+    }
+    std::copy(positions.begin(), positions.end(), fine.positionData());
+}
+
+bool LimitEvaluator::writeOBJ(int levels, const std::string& filePath, LoadProgress* progress) const {
+    if (progress) progress->beginStage(0.0f, 0.9f);
+    HalfEdgeMesh fine(TwinLayout::Paired);
+    std::vector<glm::vec3> normals;
+    refineOntoLimit(std::max(levels, 1), fine, normals);
+    if (progress && progress->isCancelled()) return false;
+    if (progress) progress->beginStage(0.9f, 1.0f);
+
+    const std::string tempPath = filePath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not write OBJ file." << std::endl;
+        return false;
+    }
+
+    // v and vn share their numbering, so every corner is written as v//v
+    std::string buffer;
+    auto append = [&](auto value) {
+        char digits[32];
+        const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+    };
+    auto appendVector = [&](const char* prefix, const glm::vec3& value) {
+        buffer += prefix;
+        for (int k = 0; k < 3; ++k) {
+            buffer += ' ';
+            append(value[k]);
+        }
+        buffer += '\n';
+    };
+    auto flush = [&] {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    };
+    const std::size_t flushSize = 1 << 20;
+    for (MeshIndex v = 0; v < fine.numVertices(); ++v) {
+        appendVector("v", fine.position(v));
+        appendVector("vn", normals[v]);
+        if (buffer.size() >= flushSize) flush();
+    }
+    for (MeshIndex f = 0; f < fine.numFaces(); ++f) {
+        buffer += 'f';
+        for (MeshIndex corner : faceVertices(fine, f)) {
+            buffer += ' ';
+            append(corner + 1);
+            buffer += "//";
+            append(corner + 1);
+        }
+        buffer += '\n';
+        if (buffer.size() >= flushSize) flush();
+    }
+    flush();
+    out.close();
+
+    std::error_code fsError;
+    const bool written = !out.fail();
+    if (written) std::filesystem::rename(tempPath, filePath, fsError);
+    if (!written || fsError) {
+        std::cerr << "Error: Could not write OBJ file." << std::endl;
+        std::filesystem::remove(tempPath, fsError);
+        return false;
+    }
+    if (progress) progress->report(1.0f);
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef LIMITEVALUATOR_H
+#define LIMITEVALUATOR_H
+
+#include "halfedgemesh.h"
+#include "loadprogress.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Exact points, tangents and normals of a base mesh's Catmull-Clark limit surface
+// at any (face, u, v), without refining the mesh as a whole. Each query takes the
+// first of these that applies:
+//   a regular quad    is a bicubic B-spline patch and is evaluated directly
+//   a quad's corner   is the corner vert's closed-form limit position, with the
+//                     limit tangent masks for its tangents, when the vert has
+//                     only quads around it and two faces if it's on a boundary
+//   one extraordinary the quad's other corners are regular and the extraordinary
+//   interior corner   one is inside, so it's Stam's patch: the query lands in a
+//                     regular sub-patch after about log2(1 / distance) levels,
+//                     whose control points are maps of the ring around the vert
+//                     tabulated per valence (up to 32)
+//   anything else     (a boundary, two extraordinary corners or a larger valence)
+//                     is refined locally: the face is cut out with the faces
+//                     around its corners and subdivided, and the query moves into
+//                     the child quad it falls in and starts over. After maxLevels
+//                     the child quad is small enough to interpolate between its
+//                     corners' limits
+// A non-quad base face is always refined once first, into quads with at most two
+// extraordinary corners, which the next level turns into quads with at most one.
+// At an extraordinary vert the parametrization is singular, and a corner query
+// there gets the masks' tangents scaled as at a regular vert.
+//
+// Parameters: a quad's (0, 0) is the tail of its first HE and u runs along that
+// HE, so (1, 0) is its head and (1, 1) the head of the next HE. Any other face is
+// split into one quad per side the way Catmull-Clark splits it: quad j sits around
+// the head of the face's j-th HE, with (0, 0) in the middle of that HE, (1, 0) at
+// its head and (0, 1) at the face's centroid.
+//
+// Every neighbourhood refined for a query stays cached for later queries on the
+// same face, positions included: make a new evaluator after the base changes.
+// The cache is locked per face, so evaluate can be called from several threads.
+class LimitEvaluator {
+public:
+    struct Location {
+        MeshIndex face;
+        MeshIndex corner; //quad j of a non-quad face, ignored for quads
+        float u;
+        float v;
+    };
+
+    struct Sample {
+        glm::vec3 position;
+        glm::vec3 tangentU; //derivatives along the location's u and v
+        glm::vec3 tangentV;
+        glm::vec3 normal;
+    };
+
+    explicit LimitEvaluator(const HalfEdgeMesh& base, int maxLevels = 12); //maxLevels >= 1
+    ~LimitEvaluator();
+
+    Sample evaluate(const Location& location) const;
+
+    //every location, grouped by face, faces in parallel. samples[i] is at locations[i]
+    void evaluate(const std::vector<Location>& locations, std::vector<Sample>& samples) const;
+
+    //the base refined levels times by CatmullClark (levels >= 1), with every vert
+    //moved onto the limit surface and its limit normal in normals[v]. Uniform
+    //refinement only gets there as levels grow. Most fine verts have their limit
+    //in closed form, the rest are evaluated at their place in the base's parameters
+    void refineOntoLimit(int levels, HalfEdgeMesh& fine, std::vector<glm::vec3>& normals) const;
+
+    //refineOntoLimit into an OBJ file with normals, written next to filePath and
+    //renamed over it. Returns false when writing fails or progress is cancelled
+    bool writeOBJ(int levels, const std::string& filePath, LoadProgress* progress = nullptr) const;
+
+private:
+    struct Cache; //pinched verts, Stam's tables and the refined neighbourhoods
+
+    const HalfEdgeMesh& base;
+    int maxLevels;
+    std::unique_ptr<Cache> cache;
+
+    void evaluateFace(MeshIndex f, const Location* locations, const std::size_t* order, std::size_t count,
+                      Sample* samples) const;
+};
+
+#endif // LIMITEVALUATOR_H
@@ -0,0 +1,36 @@
+#ifndef LOADPROGRESS_H
+#define LOADPROGRESS_H
+
+#include <atomic>
+
+// Shared between a thread running a long kernel operation (loadOBJ, loadHEDS)
+// and the thread watching it. The worker splits its run into stages and reports
+// how far into the current stage it is, polling isCancelled() between stages and
+// every few thousand items inside them. The watcher reads fraction() and may
+// cancel() at any time.
+class LoadProgress {
+public:
+    float fraction() const { return done.load(std::memory_order_relaxed); } //of the whole run, 0 to 1
+
+    //worker side: the next reports cover [begin, end) of the whole run. Stages are
+    //set before forking, so the stage bounds themselves are never shared
+    void beginStage(float begin, float end) {
+        stageBegin = begin;
+        stageEnd = end;
+        done.store(begin, std::memory_order_relaxed);
+    }
+    void report(float stageFraction) {
+        done.store(stageBegin + (stageEnd - stageBegin) * stageFraction, std::memory_order_relaxed);
+    }
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<float> done{0.0f};
+    std::atomic<bool> cancelled{false};
+    float stageBegin = 0.0f;
+    float stageEnd = 1.0f;
+};
+
+#endif // LOADPROGRESS_H
@@ -0,0 +1,287 @@
+#include "loopsubdivision.h"
+#include "circulators.h"
+#include "parallel.h"
+#include <cmath>
+
+namespace {
+
+const std::size_t grain = 1 << 12;
+
+} // namespace
+
+//dense ids for the coarse mesh's edges, which every fine index is built from
+struct LoopSubdivision::Numbering {
+    const HalfEdgeMesh& mesh;
+    MeshIndex numVerts;
+    MeshIndex numFaces;
+    MeshIndex numEdges = 0;
+    std::vector<MeshIndex> edgeIds; //dense edge id per HE, only needed in the Explicit layout
+
+    explicit Numbering(const HalfEdgeMesh& mesh);
+
+    MeshIndex edge(MeshIndex he) const { return edgeIds.empty() ? mesh.edge(he) : edgeIds[he]; }
+    bool side(MeshIndex he) const { return edgeIds.empty() ? (he & 1u) != 0 : he > mesh.sym(he); }
+
+    MeshIndex edgePoint(MeshIndex he) const { return numVerts + edge(he); }
+
+    MeshIndex halfA(MeshIndex he) const { return 4 * edge(he) + (side(he) ? 3 : 0); } //tail -> edge point
+    MeshIndex halfB(MeshIndex he) const { return 4 * edge(he) + (side(he) ? 1 : 2); } //edge point -> head
+    MeshIndex innerOut(MeshIndex f, MeshIndex j) const { return 4 * numEdges + 6 * f + 2 * j; } //in corner triangle j
+    MeshIndex innerIn(MeshIndex f, MeshIndex j) const { return 4 * numEdges + 6 * f + 2 * j + 1; } //in the middle triangle
+};
+
+LoopSubdivision::Numbering::Numbering(const HalfEdgeMesh& mesh)
+    : mesh(mesh), numVerts(mesh.numVertices()), numFaces(mesh.numFaces()) {
+    if (mesh.twinLayout() == TwinLayout::Paired) {
+        numEdges = mesh.numHalfEdges() / 2;
+    } else {
+        edgeIds.resize(mesh.numHalfEdges());
+        for (MeshIndex he = 0; he < mesh.numHalfEdges(); ++he) {
+            if (he < mesh.sym(he)) {
+                edgeIds[he] = numEdges;
+                edgeIds[mesh.sym(he)] = numEdges;
+                ++numEdges;
+            }
+        }
+    }
+}
+
+bool LoopSubdivision::isTriangleMesh(const HalfEdgeMesh& mesh) {
+    std::vector<uint8_t> rangeOk(workerCount(), 1);
+    parallelTasks(workerCount(), [&](unsigned r) {
+        std::size_t begin = std::size_t(mesh.numFaces()) * r / workerCount();
+        std::size_t end = std::size_t(mesh.numFaces()) * (r + 1) / workerCount();
+        for (MeshIndex f = static_cast<MeshIndex>(begin); f < end && rangeOk[r]; ++f) {
+            const MeshIndex he = mesh.faceEdge(f);
+            if (mesh.next(mesh.next(mesh.next(he))) != he) rangeOk[r] = 0;
+        }
+    });
+    for (uint8_t ok : rangeOk) {
+        if (!ok) return false;
+    }
+    return true;
+}
+
+MeshSizes LoopSubdivision::refinedSizes(const HalfEdgeMesh& coarse) {
+    const MeshIndex numEdges = coarse.numHalfEdges() / 2;
+    return {coarse.numVertices() + numEdges, 4 * coarse.numFaces(), 4 * numEdges + 6 * coarse.numFaces()};
+}
+
+bool LoopSubdivision::subdivide(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine) {
+    if (!isTriangleMesh(coarse)) return false;
+
+    Numbering numbering(coarse);
+    refineTopology(coarse, numbering, fine);
+    refinePositions(coarse, numbering, fine);
+    if (coarse.twinLayout() == TwinLayout::Explicit) {
+        fine.setTwinLayout(TwinLayout::Explicit);
+    }
+    return true;
+}
+
+bool LoopSubdivision::subdivideWithStencils(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine, StencilTable& stencils) {
+    if (!isTriangleMesh(coarse)) return false;
+
+    Numbering numbering(coarse);
+    refineTopology(coarse, numbering, fine);
+    stencils = refineStencils(coarse, numbering);
+    stencils.apply(coarse.positionData(), fine.positionData());
+    if (coarse.twinLayout() == TwinLayout::Explicit) {
+        fine.setTwinLayout(TwinLayout::Explicit);
+    }
+    return true;
+}
+
+//size the fine arrays exactly from the numbering and fill in next/face/vert for
+//every fine HE. Each coarse triangle writes only its own children and the halves
+//of its own HEs, so triangles run in parallel
+void LoopSubdivision::refineTopology(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine) {
+    const MeshSizes sizes = refinedSizes(coarse);
+
+    fine.clear();
+    fine.layout = TwinLayout::Paired;
+    fine.positions.resize(sizes.numVertices);
+    fine.vertEdges.assign(sizes.numVertices, NO_INDEX);
+    fine.faceEdges.resize(sizes.numFaces);
+    fine.faceColors.resize(sizes.numFaces);
+    fine.heNext.resize(sizes.numHalfEdges);
+    fine.heFace.resize(sizes.numHalfEdges);
+    fine.heVert.resize(sizes.numHalfEdges);
+
+    // corner triangle j sits around the head of the j-th HE:
+    // halfB(h_j) -> halfA(h_j+1) -> innerOut(j), and the middle triangle is
+    // innerIn(0) -> innerIn(1) -> innerIn(2)
+    parallelFor(0, numbering.numFaces, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex f = static_cast<MeshIndex>(begin); f < end; ++f) {
+            const MeshIndex middle = 4 * f + 3;
+            MeshIndex he = coarse.faceEdge(f);
+            for (MeshIndex j = 0; j < 3; ++j) {
+                const MeshIndex nextHE = coarse.next(he);
+                const MeshIndex corner = 4 * f + j;
+                const MeshIndex b = numbering.halfB(he);
+                const MeshIndex a = numbering.halfA(nextHE);
+                const MeshIndex out = numbering.innerOut(f, j);
+                const MeshIndex in = numbering.innerIn(f, j);
+
+                fine.heNext[b] = a;
+                fine.heNext[a] = out;
+                fine.heNext[out] = b;
+                fine.heNext[in] = numbering.innerIn(f, (j + 1) % 3);
+                fine.heVert[b] = coarse.vert(he);
+                fine.heVert[a] = numbering.edgePoint(nextHE);
+                fine.heVert[out] = numbering.edgePoint(he);
+                fine.heVert[in] = numbering.edgePoint(nextHE);
+                fine.heFace[b] = corner;
+                fine.heFace[a] = corner;
+                fine.heFace[out] = corner;
+                fine.heFace[in] = middle;
+
+                fine.faceEdges[corner] = b; //start on the HE that points to an original vertex
+                fine.faceColors[corner] = HalfEdgeMesh::randomColor();
+
+                // exactly one interior HE of every edge claims its edge point
+                if (!numbering.side(nextHE) || coarse.isBoundary(coarse.sym(nextHE))) {
+                    fine.vertEdges[numbering.edgePoint(nextHE)] = a;
+                }
+                he = nextHE;
+            }
+            fine.faceEdges[middle] = numbering.innerIn(f, 0);
+            fine.faceColors[middle] = coarse.faceColor(f);
+        }
+    });
+
+    // boundary HEs just split in two and keep following their loop
+    parallelFor(0, coarse.numHalfEdges(), grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            if (!coarse.isBoundary(he)) continue;
+            const MeshIndex a = numbering.halfA(he);
+            const MeshIndex b = numbering.halfB(he);
+            fine.heNext[a] = b;
+            fine.heNext[b] = numbering.halfA(coarse.next(he));
+            fine.heVert[a] = numbering.edgePoint(he);
+            fine.heVert[b] = coarse.vert(he);
+            fine.heFace[a] = NO_INDEX;
+            fine.heFace[b] = NO_INDEX;
+        }
+    });
+
+    // original verts are pointed to by the second half of their old representative
+    parallelFor(0, numbering.numVerts, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex v = static_cast<MeshIndex>(begin); v < end; ++v) {
+            MeshIndex he = coarse.vertexEdge(v);
+            fine.vertEdges[v] = he == NO_INDEX ? NO_INDEX : numbering.halfB(he);
+        }
+    });
+}
+
+// The point rules, written once for anything that can be weighted and summed.
+// Each rule adds a fine point's terms to a sink as sink.addCoarse(v, w); unlike
+// Catmull-Clark no rule needs another fine point.
+
+//edge point: 3/8 of each of the edge's verts and 1/8 of each vert opposite it
+//(a boundary edge only has one opposite vert and is split at its midpoint)
+template <typename Sink>
+void LoopSubdivision::edgePointRule(const HalfEdgeMesh& coarse, MeshIndex he, Sink& sink) {
+    const MeshIndex sym = coarse.sym(he);
+    if (coarse.isBoundary(he) || coarse.isBoundary(sym)) {
+        sink.addCoarse(coarse.vert(he), 0.5f);
+        sink.addCoarse(coarse.vert(sym), 0.5f);
+    } else {
+        sink.addCoarse(coarse.vert(he), 0.375f);
+        sink.addCoarse(coarse.vert(sym), 0.375f);
+        sink.addCoarse(coarse.vert(coarse.next(he)), 0.125f);
+        sink.addCoarse(coarse.vert(coarse.next(sym)), 0.125f);
+    }
+}
+
+//vertex point: original verts move towards their neighbours by Loop's beta
+template <typename Sink>
+void LoopSubdivision::vertexPointRule(const HalfEdgeMesh& coarse, MeshIndex v, Sink& sink) {
+    const VertexHalfEdges fan = vertexHalfEdges(coarse, v);
+    if (fan.empty()) { //vert isn't used by any face
+        sink.addCoarse(v, 1.0f);
+        return;
+    }
+
+    // count the adjacent edges and look for a boundary among the HEs pointing to v
+    float n = 0;
+    MeshIndex boundaryEdge = NO_INDEX;
+    for (MeshIndex he : fan) {
+        if (coarse.isBoundary(he)) boundaryEdge = he;
+        n += 1.0f;
+    }
+
+    if (boundaryEdge != NO_INDEX) {
+        // boundary verts only follow their two boundary neighbours
+        sink.addCoarse(v, 0.75f);
+        sink.addCoarse(coarse.vert(coarse.sym(boundaryEdge)), 0.125f);
+        sink.addCoarse(coarse.vert(coarse.next(boundaryEdge)), 0.125f);
+        return;
+    }
+
+    // beta = (5/8 - (3/8 + cos(2 pi / n) / 4)^2) / n, 1/16 for a regular vert
+    const float c = 0.375f + 0.25f * std::cos(6.2831853f / n);
+    const float beta = (0.625f - c * c) / n;
+    sink.addCoarse(v, 1.0f - n * beta);
+    for (MeshIndex he : fan) {
+        sink.addCoarse(coarse.vert(coarse.sym(he)), beta); //tail of he
+    }
+}
+
+//sums a rule's terms straight into a position
+struct LoopSubdivision::PositionSum {
+    const HalfEdgeMesh& coarse;
+    glm::vec3 total{0.0f};
+
+    void addCoarse(MeshIndex v, float weight) { total += weight * coarse.position(v); }
+};
+
+//sums a rule's terms into a stencil row over the coarse verts
+struct LoopSubdivision::StencilSum {
+    StencilAccumulator& accumulator;
+
+    void addCoarse(MeshIndex v, float weight) { accumulator.add(v, weight); }
+};
+
+//edge points and smoothed original verts, each pass only reads the coarse mesh
+void LoopSubdivision::refinePositions(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine) {
+    parallelFor(0, coarse.numHalfEdges(), grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            if (numbering.side(he)) continue; //one HE per edge
+            PositionSum sum{coarse};
+            edgePointRule(coarse, he, sum);
+            fine.positions[numbering.edgePoint(he)] = sum.total;
+        }
+    });
+
+    parallelFor(0, numbering.numVerts, grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex v = static_cast<MeshIndex>(begin); v < end; ++v) {
+            PositionSum sum{coarse};
+            vertexPointRule(coarse, v, sum);
+            fine.positions[v] = sum.total;
+        }
+    });
+}
+
+//the same passes as refinePositions, but every fine point becomes a row of
+//weights over the coarse verts. Rows are stored in fine vertex order
+StencilTable LoopSubdivision::refineStencils(const HalfEdgeMesh& coarse, const Numbering& numbering) {
+    // the HE each edge point is made from, the one on side 0
+    std::vector<MeshIndex> edgeHEs(numbering.numEdges);
+    parallelFor(0, coarse.numHalfEdges(), grain, [&](std::size_t begin, std::size_t end) {
+        for (MeshIndex he = static_cast<MeshIndex>(begin); he < end; ++he) {
+            if (!numbering.side(he)) edgeHEs[numbering.edge(he)] = he;
+        }
+    });
+
+    const MeshIndex numSources = numbering.numVerts;
+    StencilTable rows = StencilTable::build(numbering.numVerts, numSources, [&](MeshIndex v, StencilAccumulator& accumulator) {
+        StencilSum sum{accumulator};
+        vertexPointRule(coarse, v, sum);
+    });
+    rows.append(StencilTable::build(numbering.numEdges, numSources, [&](MeshIndex e, StencilAccumulator& accumulator) {
+        StencilSum sum{accumulator};
+        edgePointRule(coarse, edgeHEs[e], sum);
+    }));
+    return rows;
+}
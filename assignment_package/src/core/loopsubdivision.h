@@ -0,0 +1,56 @@
+#ifndef LOOPSUBDIVISION_H
+#define LOOPSUBDIVISION_H
+
+#include "halfedgemesh.h"
+#include "stenciltable.h"
+
+// Loop subdivision of triangle meshes, built like CatmullClark: the coarse mesh
+// is never edited, and the fine mesh's topology and positions are computed in
+// parallel passes over the coarse arrays.
+//
+// Topology: every triangle becomes four, three around its corners and one in the
+// middle. Each fine element's index follows from its coarse parent in closed form:
+//   verts  [0, V) keep their ids, edge point e is V + e
+//   tris   triangle f's corner triangle j is 4f + j, its middle triangle 4f + 3
+//   HEs    coarse HE h on edge e, side s, splits into halfA (tail -> edge point)
+//          and halfB (edge point -> head) at 4e + {0, 2} or 4e + {3, 1};
+//          the inner edge of corner triangle j is 4E + 6f + 2j (in the corner
+//          triangle) and 4E + 6f + 2j + 1 (in the middle one)
+// so twins sit at 2k and 2k + 1, and the fine mesh is built Paired.
+//
+// Positions: edge points are 3/8 of the edge's verts plus 1/8 of the two opposite
+// verts, and verts move to (1 - n beta) v + beta sum(neighbours) with Loop's beta.
+// Boundary edges are split at their midpoint and boundary verts follow the cubic
+// B-spline rule (a + 6v + b) / 8. Both read only the coarse mesh, so they run in
+// one pass each and make a stencil table just as easily.
+class LoopSubdivision {
+public:
+    static bool isTriangleMesh(const HalfEdgeMesh& mesh);
+
+    //fine gets one level of subdivision of coarse, in coarse's twin layout.
+    //Returns false (leaving fine alone) when coarse isn't all triangles
+    static bool subdivide(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine);
+
+    //like subdivide, and also fills stencils with the table that makes fine's
+    //verts out of coarse's verts (one row per fine vert)
+    static bool subdivideWithStencils(const HalfEdgeMesh& coarse, HalfEdgeMesh& fine, StencilTable& stencils);
+
+    //fine's element counts: V + E verts, four triangles per triangle and
+    //two HEs per coarse HE plus six per triangle
+    static MeshSizes refinedSizes(const HalfEdgeMesh& coarse);
+
+private:
+    struct Numbering;
+    static void refineTopology(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine);
+    static void refinePositions(const HalfEdgeMesh& coarse, const Numbering& numbering, HalfEdgeMesh& fine);
+    static StencilTable refineStencils(const HalfEdgeMesh& coarse, const Numbering& numbering);
+
+    struct PositionSum;
+    struct StencilSum;
+    template <typename Sink>
+    static void edgePointRule(const HalfEdgeMesh& coarse, MeshIndex he, Sink& sink);
+    template <typename Sink>
+    static void vertexPointRule(const HalfEdgeMesh& coarse, MeshIndex v, Sink& sink);
+};
+
+#endif // LOOPSUBDIVISION_H
@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The contents are addressed in place
+// through data()/size(), nothing is copied into user memory. The mapping is
+// released when the object is destroyed or close() is called.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filePath); //false if the file can't be opened or mapped
+    void close();
+
+    const char* data() const { return begin; }
+    std::size_t size() const { return length; }
+    bool isOpen() const { return opened; }
+
+private:
+    const char* begin = nullptr; //null for an empty file
+    std::size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
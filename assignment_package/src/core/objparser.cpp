@@ -0,0 +1,266 @@
+#include "objparser.h"
+#include "parallel.h"
+#include <cerrno>
+#include <cfloat>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+namespace {
+
+//'\n' is not whitespace here, lines are split before tokenizing
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+inline const char* findLineEnd(const char* p, const char* end) {
+    const void* newline = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+//statement keyword at p, e.g. "v" or "f", followed by whitespace
+inline bool startsStatement(const char* p, const char* lineEnd, char keyword) {
+    return lineEnd - p >= 2 && p[0] == keyword && isSpace(p[1]);
+}
+
+#if !(defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L)
+//strtof in the "C" locale. QApplication adopts the user's locale, and in one
+//with a decimal comma plain strtof stops at the '.' of "1.5"
+#ifdef _WIN32
+float strtofClassic(const char* token, char** tokenEnd) {
+    static const _locale_t classic = _create_locale(LC_NUMERIC, "C");
+    return _strtof_l(token, tokenEnd, classic);
+}
+#else
+float strtofClassic(const char* token, char** tokenEnd) {
+    static const locale_t classic = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+    return strtof_l(token, tokenEnd, classic);
+}
+#endif
+#endif
+
+//read a float at p and advance p past it
+bool parseFloat(const char*& p, const char* end, float& value) {
+    if (p < end && *p == '+') ++p; //from_chars doesn't accept a leading '+'
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec == std::errc::result_out_of_range) {
+        //from_chars reports underflow and overflow alike and leaves value
+        //untouched. Reread as double to tell them apart: a tiny value (a denormal
+        //in scanned data) reads as 0, one too large for a float is an error
+        //rather than a vertex silently moved to the origin
+        double wide = 0.0;
+        if (std::from_chars(p, end, wide).ec != std::errc() || std::fabs(wide) > FLT_MAX) return false;
+        value = 0.0f;
+    } else if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+#else
+    //this standard library has no floating-point from_chars. strtof needs a
+    //terminated string and the mapped file has none, so copy the token first.
+    //A token too long for the copy is rejected, not cut short
+    char token[64];
+    std::size_t length = 0;
+    while (p + length < end && !isSpace(p[length])) {
+        if (length == sizeof(token) - 1) return false;
+        token[length] = p[length];
+        ++length;
+    }
+    token[length] = '\0';
+    char* tokenEnd = nullptr;
+    errno = 0;
+    value = strtofClassic(token, &tokenEnd);
+    if (tokenEnd == token) return false;
+    if (errno == ERANGE) {
+        if (std::isinf(value)) return false; //overflow is an error, see above
+        value = 0.0f;
+    }
+    p += tokenEnd - token;
+    return true;
+#endif
+}
+
+//what one worker read out of its chunk. Positive indices are already absolute;
+//relative ones were resolved against the chunk's own vertex count and are listed
+//in relativeCorners so they can be shifted once earlier chunks are counted
+struct ObjChunk {
+    ObjPolygons polygons;
+    std::vector<MeshIndex> relativeCorners;
+    std::size_t numLines = 0;
+    const char* errorMessage = nullptr; //null if the chunk parsed
+};
+
+//parse one chunk. progress (if any) is polled every few thousand lines, and
+//reportsProgress chunks also tell it how far into the chunk they are
+void parseChunk(const char* begin, const char* end, ObjChunk& chunk, LoadProgress* progress, bool reportsProgress) {
+    ObjPolygons& out = chunk.polygons;
+    std::size_t& lineNumber = chunk.numLines;
+    auto fail = [&](const char* message) {
+        chunk.errorMessage = message;
+    };
+
+    const char* p = begin;
+    while (p < end) {
+        ++lineNumber;
+        if (progress && lineNumber % 16384 == 0) {
+            if (progress->isCancelled()) return fail("cancelled");
+            if (reportsProgress) progress->report(static_cast<float>(p - begin) / static_cast<float>(end - begin));
+        }
+        const char* lineEnd = findLineEnd(p, end);
+        p = skipSpaces(p, lineEnd);
+
+        if (startsStatement(p, lineEnd, 'v')) {
+            // vertex position, an optional w is ignored
+            glm::vec3 pos;
+            p += 2;
+            for (int i = 0; i < 3; ++i) {
+                p = skipSpaces(p, lineEnd);
+                if (!parseFloat(p, lineEnd, pos[i])) return fail("malformed vertex position");
+            }
+            out.positions.push_back(pos);
+
+        } else if (startsStatement(p, lineEnd, 'f')) {
+            // keep the position index of every "v/vt/vn" corner
+            std::size_t firstCorner = out.cornerVerts.size();
+            p += 2;
+            while ((p = skipSpaces(p, lineEnd)) < lineEnd) {
+                int64_t index = 0;
+                std::from_chars_result result = std::from_chars(p, lineEnd, index);
+                if (result.ec != std::errc() || index == 0) return fail("malformed face index");
+                p = result.ptr;
+                if (p < lineEnd && !isSpace(*p) && *p != '/') return fail("malformed face index");
+                while (p < lineEnd && !isSpace(*p)) ++p; //skip the uv/normal indices
+
+                // OBJ indices are 1-based, negative ones count back from the last vertex read.
+                // A relative index may reach into an earlier chunk, so it's stored modulo 2^32
+                // and only range checked after the chunk offset is added
+                int64_t resolved = index - 1;
+                if (index < 0) {
+                    resolved = static_cast<int64_t>(out.positions.size()) + index;
+                    chunk.relativeCorners.push_back(static_cast<MeshIndex>(out.cornerVerts.size()));
+                }
+                if (resolved >= static_cast<int64_t>(NO_INDEX) || resolved < -static_cast<int64_t>(NO_INDEX)) {
+                    return fail("face index out of range");
+                }
+                out.cornerVerts.push_back(static_cast<MeshIndex>(resolved));
+            }
+            if (out.cornerVerts.size() - firstCorner < 3) return fail("face with fewer than 3 vertices");
+            out.faceOffsets.push_back(static_cast<MeshIndex>(out.cornerVerts.size()));
+        }
+
+        p = lineEnd < end ? lineEnd + 1 : end;
+    }
+}
+
+//split [begin, end) into numChunks pieces that each start at the beginning of a line
+std::vector<const char*> lineAlignedSplits(const char* begin, const char* end, unsigned numChunks) {
+    std::vector<const char*> splits{begin};
+    std::size_t size = static_cast<std::size_t>(end - begin);
+    for (unsigned i = 1; i < numChunks; ++i) {
+        const char* split = std::max(begin + size * i / numChunks, splits.back());
+        split = findLineEnd(split, end);
+        splits.push_back(split < end ? split + 1 : end);
+    }
+    splits.push_back(end);
+    return splits;
+}
+
+} // namespace
+
+void ObjPolygons::clear() {
+    positions.clear();
+    faceOffsets.assign(1, 0);
+    cornerVerts.clear();
+}
+
+bool parseOBJ(const char* begin, const char* end, ObjPolygons& out, std::string& error,
+              unsigned numThreads, LoadProgress* progress) {
+    const std::size_t minChunkBytes = 1 << 20; //smaller chunks cost more in thread startup than they save
+    std::size_t size = static_cast<std::size_t>(end - begin);
+    unsigned numChunks = numThreads ? numThreads : workerCount();
+    numChunks = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(numChunks, size / minChunkBytes)));
+
+    std::vector<const char*> splits = lineAlignedSplits(begin, end, numChunks);
+    std::vector<ObjChunk> chunks(numChunks);
+    parallelTasks(numChunks, [&](unsigned i) {
+        parseChunk(splits[i], splits[i + 1], chunks[i], progress, i == 0);
+    });
+    if (progress && progress->isCancelled()) {
+        error = "cancelled";
+        out.clear();
+        return false;
+    }
+
+    // prefix sums give every chunk its place in the output. The first failing
+    // chunk follows only complete chunks, so its line number can be made global
+    std::vector<std::size_t> vertOffsets(numChunks + 1, 0);
+    std::vector<std::size_t> faceOffsets(numChunks + 1, 0);
+    std::vector<std::size_t> cornerOffsets(numChunks + 1, 0);
+    std::size_t lineOffset = 0;
+    for (unsigned i = 0; i < numChunks; ++i) {
+        const ObjChunk& chunk = chunks[i];
+        if (chunk.errorMessage) {
+            error = "line " + std::to_string(lineOffset + chunk.numLines) + ": " + chunk.errorMessage;
+            out.clear();
+            return false;
+        }
+        lineOffset += chunk.numLines;
+        vertOffsets[i + 1] = vertOffsets[i] + chunk.polygons.positions.size();
+        faceOffsets[i + 1] = faceOffsets[i] + chunk.polygons.numFaces();
+        cornerOffsets[i + 1] = cornerOffsets[i] + chunk.polygons.cornerVerts.size();
+    }
+    if (vertOffsets.back() >= NO_INDEX || cornerOffsets.back() >= NO_INDEX) {
+        error = "too many elements for 32-bit indices";
+        out.clear();
+        return false;
+    }
+
+    out.positions.resize(vertOffsets.back());
+    out.faceOffsets.resize(faceOffsets.back() + 1);
+    out.faceOffsets[0] = 0;
+    out.cornerVerts.resize(cornerOffsets.back());
+
+    // concatenate, fixing up relative indices and checking every index now that
+    // the vertex count is known (positive indices may point ahead of their face)
+    const MeshIndex numVerts = static_cast<MeshIndex>(vertOffsets.back());
+    std::vector<char> indexInRange(numChunks, 1);
+    parallelTasks(numChunks, [&](unsigned i) {
+        const ObjPolygons& local = chunks[i].polygons;
+        std::copy(local.positions.begin(), local.positions.end(), out.positions.begin() + vertOffsets[i]);
+
+        const MeshIndex cornerOffset = static_cast<MeshIndex>(cornerOffsets[i]);
+        for (MeshIndex f = 0; f < local.numFaces(); ++f) {
+            out.faceOffsets[faceOffsets[i] + f + 1] = cornerOffset + local.faceOffsets[f + 1];
+        }
+
+        MeshIndex* corners = out.cornerVerts.data() + cornerOffsets[i];
+        std::copy(local.cornerVerts.begin(), local.cornerVerts.end(), corners);
+        const MeshIndex vertOffset = static_cast<MeshIndex>(vertOffsets[i]);
+        for (MeshIndex c : chunks[i].relativeCorners) {
+            corners[c] += vertOffset; //wraps back into range unless it pointed before vertex 1
+        }
+        for (std::size_t c = 0; c < local.cornerVerts.size(); ++c) {
+            if (corners[c] >= numVerts) indexInRange[i] = 0;
+        }
+    });
+
+    if (std::find(indexInRange.begin(), indexInRange.end(), 0) != indexInRange.end()) {
+        error = "face references a missing vertex";
+        out.clear();
+        return false;
+    }
+    return true;
+}
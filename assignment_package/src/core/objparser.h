@@ -0,0 +1,36 @@
+#ifndef OBJPARSER_H
+#define OBJPARSER_H
+
+#include "halfedgemesh.h"
+#include "loadprogress.h"
+#include <string>
+#include <vector>
+
+// Polygon soup read out of an OBJ file: vertex positions plus every face as a
+// run of position indices. Face f's corners are
+// cornerVerts[faceOffsets[f]] .. cornerVerts[faceOffsets[f + 1] - 1].
+struct ObjPolygons {
+    std::vector<glm::vec3> positions;
+    std::vector<MeshIndex> faceOffsets{0}; //numFaces() + 1 entries
+    std::vector<MeshIndex> cornerVerts; //0-based, already resolved from relative indices
+
+    MeshIndex numFaces() const { return static_cast<MeshIndex>(faceOffsets.size() - 1); }
+    void clear();
+};
+
+// Tokenizes the OBJ text in [begin, end) in place: no per-line strings or
+// streams, numbers are read straight out of the buffer with std::from_chars.
+// Understands "v x y z [w]" and "f" corners written as v, v/vt, v/vt/vn or v//vn,
+// with positive (1-based) or negative (relative) indices. Every other statement
+// (vt, vn, o, g, s, usemtl, comments...) is skipped.
+//
+// Large inputs are split into line-aligned chunks parsed on numThreads threads
+// (0 = one per core); the per-chunk buffers are then concatenated at offsets
+// from a prefix sum over their sizes.
+// Returns false and fills error (with the line number) on malformed input.
+// With a progress, the first chunk reports how far it got and every chunk stops
+// early once it's cancelled; parseOBJ then returns false with error "cancelled".
+bool parseOBJ(const char* begin, const char* end, ObjPolygons& out, std::string& error,
+              unsigned numThreads = 0, LoadProgress* progress = nullptr);
+
+#endif // OBJPARSER_H
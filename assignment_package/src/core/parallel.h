@@ -0,0 +1,53 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Minimal fork/join helpers for the kernel. Every call spawns its workers and
+// joins them before returning, so callers never see a running thread.
+
+//threads to split work over, at least 1. Asked once: hardware_concurrency can
+//read the system's CPU list on every call, which small meshes would pay for
+inline unsigned workerCount() {
+    static const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    return count;
+}
+
+//run task(i) for every i in [0, numTasks), each on its own thread (task 0 on the caller's)
+template <typename Task>
+void parallelTasks(unsigned numTasks, Task&& task) {
+    if (numTasks <= 1) {
+        if (numTasks == 1) task(0u);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(numTasks - 1);
+    for (unsigned i = 1; i < numTasks; ++i) {
+        workers.emplace_back([&task, i] { task(i); });
+    }
+    task(0u);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+//run body(rangeBegin, rangeEnd) over [begin, end) split into contiguous ranges of at
+//least minGrain items, one range per worker. Small ranges run on the calling thread
+template <typename Body>
+void parallelFor(std::size_t begin, std::size_t end, std::size_t minGrain, Body&& body) {
+    if (end <= begin) return;
+    std::size_t count = end - begin;
+    std::size_t numRanges = std::min<std::size_t>(workerCount(), (count + minGrain - 1) / std::max<std::size_t>(minGrain, 1));
+    numRanges = std::max<std::size_t>(numRanges, 1);
+
+    parallelTasks(static_cast<unsigned>(numRanges), [&](unsigned i) {
+        std::size_t rangeBegin = begin + count * i / numRanges;
+        std::size_t rangeEnd = begin + count * (i + 1) / numRanges;
+        body(rangeBegin, rangeEnd);
+    });
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,50 @@
+#include "radixsort.h"
+#include "parallel.h"
+#include <array>
+
+void parallelRadixSort(std::vector<KeyedIndex>& items, uint8_t byteMask) {
+    const std::size_t count = items.size();
+    const std::size_t minGrain = 1 << 16; //per-thread histograms aren't worth it below this
+    const unsigned numRanges = static_cast<unsigned>(std::max<std::size_t>(1,
+        std::min<std::size_t>(workerCount(), count / minGrain)));
+    auto rangeBegin = [&](unsigned r) { return count * r / numRanges; };
+
+    std::vector<KeyedIndex> scratch(count);
+    std::vector<std::array<std::size_t, 256>> offsets(numRanges);
+
+    for (unsigned byte = 0; byte < 8; ++byte) {
+        if (!(byteMask & (1u << byte))) continue;
+        const unsigned shift = byte * 8;
+
+        parallelTasks(numRanges, [&](unsigned r) {
+            std::array<std::size_t, 256>& histogram = offsets[r];
+            histogram.fill(0);
+            for (std::size_t i = rangeBegin(r); i < rangeBegin(r + 1); ++i) {
+                ++histogram[(items[i].key >> shift) & 0xFF];
+            }
+        });
+
+        // bucket d of range r starts after every smaller digit and after digit d of earlier ranges
+        std::size_t total = 0;
+        bool singleBucket = false;
+        for (unsigned digit = 0; digit < 256; ++digit) {
+            std::size_t digitCount = 0;
+            for (unsigned r = 0; r < numRanges; ++r) {
+                std::size_t n = offsets[r][digit];
+                offsets[r][digit] = total;
+                total += n;
+                digitCount += n;
+            }
+            if (digitCount == count) singleBucket = true;
+        }
+        if (singleBucket) continue; //every key has the same digit, the pass would be a copy
+
+        parallelTasks(numRanges, [&](unsigned r) {
+            std::array<std::size_t, 256>& next = offsets[r];
+            for (std::size_t i = rangeBegin(r); i < rangeBegin(r + 1); ++i) {
+                scratch[next[(items[i].key >> shift) & 0xFF]++] = items[i];
+            }
+        });
+        items.swap(scratch);
+    }
+}
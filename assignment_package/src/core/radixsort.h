@@ -0,0 +1,19 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <cstdint>
+#include <vector>
+
+// 64-bit key with a 32-bit payload, e.g. a packed undirected edge and the HE on it
+struct KeyedIndex {
+    uint64_t key;
+    uint32_t value;
+};
+
+// Stable LSD radix sort on key, 8 bits per pass. Each pass builds per-thread
+// histograms, prefix-sums them into per-thread bucket offsets and scatters in
+// parallel. Only the bytes set in byteMask (bit i = byte i of the key) are
+// sorted on; the caller clears the bytes it knows are zero in every key.
+void parallelRadixSort(std::vector<KeyedIndex>& items, uint8_t byteMask = 0xFF);
+
+#endif // RADIXSORT_H
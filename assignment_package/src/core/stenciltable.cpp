@@ -0,0 +1,54 @@
+#include "stenciltable.h"
+
+StencilAccumulator::StencilAccumulator(MeshIndex numSources)
+    : dense(numSources, 0.0f), present(numSources, 0) {}
+
+void StencilAccumulator::flush(std::vector<MeshIndex>& sources, std::vector<float>& weights) {
+    for (MeshIndex source : touched) {
+        sources.push_back(source);
+        weights.push_back(dense[source]);
+        dense[source] = 0.0f;
+        present[source] = 0;
+    }
+    touched.clear();
+}
+
+void StencilTable::apply(const glm::vec3* in, glm::vec3* out) const {
+    const MeshIndex* rowOffsets = offsets.data();
+    const MeshIndex* rowSources = sources.data();
+    const float* rowWeights = weights.data();
+    parallelFor(0, numRows(), 1 << 12, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t row = begin; row < end; ++row) {
+            // straight-line multiply-adds over the flat arrays, the compiler can vectorize the x/y/z lanes
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            for (MeshIndex k = rowOffsets[row]; k < rowOffsets[row + 1]; ++k) {
+                const glm::vec3& p = in[rowSources[k]];
+                const float w = rowWeights[k];
+                x += w * p.x;
+                y += w * p.y;
+                z += w * p.z;
+            }
+            out[row] = glm::vec3(x, y, z);
+        }
+    });
+}
+
+StencilTable StencilTable::composedWith(const StencilTable& inner) const {
+    return build(numRows(), inner.numSources(), [&](MeshIndex row, StencilAccumulator& accumulator) {
+        forEachEntry(row, [&](MeshIndex middle, float weight) {
+            inner.forEachEntry(middle, [&](MeshIndex source, float innerWeight) {
+                accumulator.add(source, weight * innerWeight);
+            });
+        });
+    });
+}
+
+void StencilTable::append(const StencilTable& rows) {
+    const MeshIndex base = static_cast<MeshIndex>(sources.size());
+    sources.insert(sources.end(), rows.sources.begin(), rows.sources.end());
+    weights.insert(weights.end(), rows.weights.begin(), rows.weights.end());
+    offsets.reserve(offsets.size() + rows.numRows());
+    for (MeshIndex r = 1; r < rows.offsets.size(); ++r) {
+        offsets.push_back(base + rows.offsets[r]);
+    }
+}
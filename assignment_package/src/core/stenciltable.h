@@ -0,0 +1,98 @@
+#ifndef STENCILTABLE_H
+#define STENCILTABLE_H
+
+#include "halfedgemesh.h"
+#include "parallel.h"
+#include <vector>
+
+// Sums weighted sources into one stencil row. Weights for the same source are
+// merged through a dense array over all sources, and only the touched entries
+// are visited when the row is written out.
+class StencilAccumulator {
+public:
+    explicit StencilAccumulator(MeshIndex numSources);
+
+    void add(MeshIndex source, float weight) {
+        if (!present[source]) {
+            present[source] = 1;
+            touched.push_back(source);
+        }
+        dense[source] += weight;
+    }
+    //append the row's entries and reset for the next row
+    void flush(std::vector<MeshIndex>& sources, std::vector<float>& weights);
+
+private:
+    std::vector<float> dense;
+    std::vector<uint8_t> present;
+    std::vector<MeshIndex> touched;
+};
+
+// Sparse matrix in compressed rows: row r of the output is the weighted sum
+// of sources[k] for k in [offsets[r], offsets[r + 1]). Used to make refined
+// vertices out of cage vertices without touching any topology.
+class StencilTable {
+public:
+    StencilTable() = default;
+
+    MeshIndex numRows() const { return static_cast<MeshIndex>(offsets.size() - 1); }
+    MeshIndex numSources() const { return sourceCount; }
+    std::size_t numEntries() const { return sources.size(); }
+
+    template <typename F>
+    void forEachEntry(MeshIndex row, F&& f) const {
+        for (MeshIndex k = offsets[row]; k < offsets[row + 1]; ++k) {
+            f(sources[k], weights[k]);
+        }
+    }
+
+    //out[r] = sum of weight * in[source] over row r, rows in parallel.
+    //in has numSources() entries, out numRows()
+    void apply(const glm::vec3* in, glm::vec3* out) const;
+
+    //this table's rows over inner's sources instead of over inner's rows
+    StencilTable composedWith(const StencilTable& inner) const;
+
+    void append(const StencilTable& rows); //rows must have the same sources
+
+    //build numRows rows in parallel; rowFn(row, accumulator) adds the row's entries
+    template <typename RowFn>
+    static StencilTable build(MeshIndex numRows, MeshIndex numSources, RowFn&& rowFn);
+
+private:
+    MeshIndex sourceCount = 0;
+    std::vector<MeshIndex> offsets{0}; //numRows() + 1 entries
+    std::vector<MeshIndex> sources;
+    std::vector<float> weights;
+};
+
+template <typename RowFn>
+StencilTable StencilTable::build(MeshIndex numRows, MeshIndex numSources, RowFn&& rowFn) {
+    const std::size_t minGrain = 1 << 12;
+    const unsigned numRanges = static_cast<unsigned>(std::max<std::size_t>(1,
+        std::min<std::size_t>(workerCount(), numRows / minGrain)));
+
+    std::vector<StencilTable> parts(numRanges);
+    parallelTasks(numRanges, [&](unsigned r) {
+        StencilTable& part = parts[r];
+        part.sourceCount = numSources;
+        StencilAccumulator accumulator(numSources);
+        const MeshIndex begin = static_cast<MeshIndex>(std::size_t(numRows) * r / numRanges);
+        const MeshIndex end = static_cast<MeshIndex>(std::size_t(numRows) * (r + 1) / numRanges);
+        part.offsets.reserve(end - begin + 1);
+        for (MeshIndex row = begin; row < end; ++row) {
+            rowFn(row, accumulator);
+            accumulator.flush(part.sources, part.weights);
+            part.offsets.push_back(static_cast<MeshIndex>(part.sources.size()));
+        }
+    });
+
+    StencilTable table;
+    table.sourceCount = numSources;
+    for (const StencilTable& part : parts) {
+        table.append(part);
+    }
+    return table;
+}
+
+#endif // STENCILTABLE_H
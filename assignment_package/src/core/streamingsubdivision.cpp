@@ -0,0 +1,370 @@
+#include "streamingsubdivision.h"
+#include "catmullclark.h"
+#include "circulators.h"
+#include "loopsubdivision.h"
+#include "objparser.h"
+#include "parallel.h"
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+const std::size_t grain = 1 << 12;
+const int maxLevels = 16; //keeps a vert's place along its base edge in 32 bits
+
+// which base element a fine vert descends from: a base vert, a point along a
+// base edge, or the inside of a base face
+enum class Ancestor : uint8_t { Vertex, Edge, Face };
+
+struct VertexTag {
+    Ancestor kind;
+    MeshIndex id; //base vert or base edge, unused for faces
+    uint32_t t; //along a base edge, in steps of 2^-level from the edge's tail
+};
+
+// base faces grouped into clusters, cluster c's faces are faces[start[c], start[c + 1])
+struct Partition {
+    std::vector<MeshIndex> clusterOf;
+    std::vector<MeshIndex> faces;
+    std::vector<MeshIndex> start{0};
+
+    MeshIndex numClusters() const { return static_cast<MeshIndex>(start.size() - 1); }
+};
+
+//grow clusters breadth first across edges until the next face would take one
+//past budget fine faces. Every cluster has at least one face
+template <typename FineFaces>
+Partition partitionFaces(const HalfEdgeMesh& base, uint64_t budget, FineFaces&& fineFaces) {
+    Partition partition;
+    partition.clusterOf.assign(base.numFaces(), NO_INDEX);
+    partition.faces.reserve(base.numFaces());
+    std::vector<MeshIndex> queuedIn(base.numFaces(), NO_INDEX);
+    std::vector<MeshIndex> frontier;
+
+    for (MeshIndex seed = 0; seed < base.numFaces(); ++seed) {
+        if (partition.clusterOf[seed] != NO_INDEX) continue;
+        const MeshIndex c = partition.numClusters();
+        uint64_t used = 0;
+        frontier.assign(1, seed);
+        queuedIn[seed] = c;
+        for (std::size_t head = 0; head < frontier.size(); ++head) {
+            const MeshIndex f = frontier[head];
+            if (partition.clusterOf[f] != NO_INDEX) continue;
+            const uint64_t size = fineFaces(f);
+            if (used > 0 && used + size > budget) break;
+            partition.clusterOf[f] = c;
+            partition.faces.push_back(f);
+            used += size;
+
+            for (MeshIndex he : faceHalfEdges(base, f)) {
+                const MeshIndex g = base.face(base.sym(he));
+                if (g != NO_INDEX && partition.clusterOf[g] == NO_INDEX && queuedIn[g] != c) {
+                    queuedIn[g] = c;
+                    frontier.push_back(g);
+                }
+            }
+        }
+        partition.start.push_back(static_cast<MeshIndex>(partition.faces.size()));
+    }
+    return partition;
+}
+
+// a fine vert on a cluster border: where it was written, and how many more
+// clusters will ask for it
+struct SharedVert {
+    uint64_t index;
+    MeshIndex usersLeft;
+};
+
+// OBJ text for a SubdivisionSink, formatted with std::to_chars into a buffer
+// that's flushed every megabyte
+class ObjWriter : public SubdivisionSink {
+public:
+    explicit ObjWriter(std::ostream& out) : out(out) { buffer.reserve(flushSize + 256); }
+
+    bool addVertices(const glm::vec3* positions, std::size_t count) override {
+        for (std::size_t i = 0; i < count; ++i) {
+            buffer += 'v';
+            for (int k = 0; k < 3; ++k) {
+                buffer += ' ';
+                append(positions[i][k]);
+            }
+            buffer += '\n';
+            if (buffer.size() >= flushSize && !flush()) return false;
+        }
+        return true;
+    }
+
+    bool addFaces(const uint64_t* corners, std::size_t count, int sides) override {
+        for (std::size_t i = 0; i < count; ++i) {
+            buffer += 'f';
+            for (int j = 0; j < sides; ++j) {
+                buffer += ' ';
+                append(corners[sides * i + j] + 1);
+            }
+            buffer += '\n';
+            if (buffer.size() >= flushSize && !flush()) return false;
+        }
+        return true;
+    }
+
+    bool flush() {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+        return !out.fail();
+    }
+
+private:
+    static const std::size_t flushSize = 1 << 20;
+    std::ostream& out;
+    std::string buffer;
+
+    template <typename T>
+    void append(T value) {
+        char digits[32];
+        const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr);
+    }
+};
+
+} // namespace
+
+bool StreamingSubdivision::subdivide(const HalfEdgeMesh& base, const Options& options, SubdivisionSink& sink,
+                                     LoadProgress* progress) {
+    const int levels = std::clamp(options.levels, 1, maxLevels);
+    const bool loop = options.scheme == SubdivisionScheme::Loop && LoopSubdivision::isTriangleMesh(base);
+    const int sides = loop ? 3 : 4;
+    const bool paired = base.twinLayout() == TwinLayout::Paired;
+    if (progress) progress->beginStage(0.0f, 1.0f);
+
+    // an n-gon becomes n quads and then four per level, a triangle four per level
+    const Partition partition = partitionFaces(base, std::max<uint64_t>(options.clusterFaces, 1), [&](MeshIndex f) {
+        const uint64_t perLevel = uint64_t(1) << (2 * (levels - 1));
+        return loop ? 4 * perLevel : base.countEdgesInFace(f) * perLevel;
+    });
+
+    // the number of clusters around every base vert, counted over each cluster's corners
+    std::vector<MeshIndex> vertClusters(base.numVertices(), 0);
+    std::vector<MeshIndex> vertStamp(base.numVertices(), NO_INDEX);
+    for (MeshIndex c = 0; c < partition.numClusters(); ++c) {
+        for (MeshIndex k = partition.start[c]; k < partition.start[c + 1]; ++k) {
+            for (MeshIndex v : faceVertices(base, partition.faces[k])) {
+                if (vertStamp[v] != c) {
+                    vertStamp[v] = c;
+                    ++vertClusters[v];
+                }
+            }
+        }
+    }
+    vertStamp.assign(base.numVertices(), NO_INDEX);
+
+    auto edgeHE = [&](MeshIndex e) { return paired ? 2 * e : e; };
+    auto edgeTail = [&](MeshIndex e) { return base.vert(base.sym(edgeHE(e))); };
+    auto edgeOnBorder = [&](MeshIndex e) {
+        const MeshIndex f = base.face(edgeHE(e));
+        const MeshIndex g = base.face(base.sym(edgeHE(e)));
+        return f != NO_INDEX && g != NO_INDEX && partition.clusterOf[f] != partition.clusterOf[g];
+    };
+
+    // every face around every base vert, from all the HEs ending at it. A vert's
+    // fan misses the faces of its other fans where the base is pinched, and the
+    // halo needs all of them for the submesh to refine like the base does
+    std::vector<MeshIndex> vertFaceStart(base.numVertices() + 1, 0);
+    for (MeshIndex he = 0; he < base.numHalfEdges(); ++he) {
+        if (!base.isBoundary(he)) ++vertFaceStart[base.vert(he) + 1];
+    }
+    for (MeshIndex v = 0; v < base.numVertices(); ++v) {
+        vertFaceStart[v + 1] += vertFaceStart[v];
+    }
+    std::vector<MeshIndex> vertFaces(vertFaceStart.back());
+    {
+        std::vector<MeshIndex> fill(vertFaceStart.begin(), vertFaceStart.end() - 1);
+        for (MeshIndex he = 0; he < base.numHalfEdges(); ++he) {
+            if (!base.isBoundary(he)) vertFaces[fill[base.vert(he)]++] = base.face(he);
+        }
+    }
+
+    std::unordered_map<uint64_t, SharedVert> shared;
+    std::vector<MeshIndex> faceStamp(base.numFaces(), NO_INDEX);
+    std::vector<MeshIndex> localVert(base.numVertices());
+    HalfEdgeMesh refined[2] = {HalfEdgeMesh(TwinLayout::Paired), HalfEdgeMesh(TwinLayout::Paired)};
+    uint64_t numWritten = 0;
+
+    for (MeshIndex c = 0; c < partition.numClusters(); ++c) {
+        if (progress) {
+            progress->report(static_cast<float>(c) / partition.numClusters());
+            if (progress->isCancelled()) return false;
+        }
+
+        // the cluster's faces first, then every other face around their verts
+        std::vector<MeshIndex> region(partition.faces.begin() + partition.start[c],
+                                      partition.faces.begin() + partition.start[c + 1]);
+        const MeshIndex numCore = static_cast<MeshIndex>(region.size());
+        for (MeshIndex f : region) {
+            faceStamp[f] = c;
+        }
+        for (MeshIndex k = 0; k < numCore; ++k) {
+            for (MeshIndex corner : faceVertices(base, region[k])) {
+                for (MeshIndex i = vertFaceStart[corner]; i < vertFaceStart[corner + 1]; ++i) {
+                    const MeshIndex face = vertFaces[i];
+                    if (faceStamp[face] != c) {
+                        faceStamp[face] = c;
+                        region.push_back(face);
+                    }
+                }
+            }
+        }
+
+        ObjPolygons polygons;
+        std::vector<VertexTag> tags;
+        for (MeshIndex f : region) {
+            for (MeshIndex v : faceVertices(base, f)) {
+                if (vertStamp[v] != c) {
+                    vertStamp[v] = c;
+                    localVert[v] = static_cast<MeshIndex>(polygons.positions.size());
+                    polygons.positions.push_back(base.position(v));
+                    tags.push_back({Ancestor::Vertex, v, 0});
+                }
+                polygons.cornerVerts.push_back(localVert[v]);
+            }
+            polygons.faceOffsets.push_back(static_cast<MeshIndex>(polygons.cornerVerts.size()));
+        }
+
+        HalfEdgeMesh submesh(TwinLayout::Paired);
+        submesh.buildFromPolygons(polygons);
+
+        // the base edge under every submesh edge. A submesh face starts on the HE
+        // ending at its first corner, just like the base face it was copied from.
+        // Every vert also takes the HE its base vert has: at a pinched vert that
+        // picks the fan the subdivision rules use, which the submesh's own face
+        // order could otherwise swap for another one
+        std::vector<MeshIndex> edgeTags(submesh.numHalfEdges() / 2, NO_INDEX);
+        for (MeshIndex k = 0; k < submesh.numFaces(); ++k) {
+            FaceHalfEdges::iterator he = faceHalfEdges(base, region[k]).begin();
+            for (MeshIndex local : faceHalfEdges(submesh, k)) {
+                edgeTags[submesh.edge(local)] = base.edge(*he);
+                if (base.vertexEdge(base.vert(*he)) == *he) submesh.setVertex(local, submesh.vert(local));
+                ++he;
+            }
+        }
+
+        // refine, following every vert and edge back to its base ancestor. The
+        // cluster's own faces come first, so their children stay a prefix
+        const HalfEdgeMesh* coarse = &submesh;
+        MeshIndex numKept = numCore;
+        for (int level = 0; level < levels; ++level) {
+            HalfEdgeMesh& fine = refined[level % 2];
+            if (loop) {
+                LoopSubdivision::subdivide(*coarse, fine);
+            } else {
+                CatmullClark::subdivide(*coarse, fine);
+            }
+            numKept = !loop && level == 0 ? polygons.faceOffsets[numCore] : 4 * numKept;
+
+            const MeshIndex numVerts = coarse->numVertices();
+            const MeshIndex numEdges = coarse->numHalfEdges() / 2;
+            const MeshIndex firstEdgePoint = loop ? numVerts : numVerts + coarse->numFaces();
+            std::vector<VertexTag> fineTags(fine.numVertices(), VertexTag{Ancestor::Face, NO_INDEX, 0});
+            std::vector<MeshIndex> fineEdgeTags(fine.numHalfEdges() / 2, NO_INDEX);
+            parallelFor(0, numVerts, grain, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t v = begin; v < end; ++v) {
+                    fineTags[v] = tags[v];
+                    fineTags[v].t *= 2;
+                }
+            });
+            parallelFor(0, numEdges, grain, [&](std::size_t begin, std::size_t end) {
+                for (MeshIndex e = static_cast<MeshIndex>(begin); e < end; ++e) {
+                    // the halves of an edge are fine edges 2e and 2e + 1 in both schemes
+                    const MeshIndex baseEdge = edgeTags[e];
+                    fineEdgeTags[2 * e] = baseEdge;
+                    fineEdgeTags[2 * e + 1] = baseEdge;
+                    if (baseEdge == NO_INDEX) continue;
+
+                    uint32_t t = 0;
+                    for (MeshIndex v : {coarse->vert(2 * e), coarse->vert(2 * e + 1)}) {
+                        const VertexTag& endpoint = tags[v];
+                        if (endpoint.kind == Ancestor::Edge) {
+                            t += endpoint.t;
+                        } else if (endpoint.id != edgeTail(baseEdge)) {
+                            t += uint32_t(1) << level;
+                        }
+                    }
+                    fineTags[firstEdgePoint + e] = {Ancestor::Edge, baseEdge, t};
+                }
+            });
+            tags = std::move(fineTags);
+            edgeTags = std::move(fineEdgeTags);
+            coarse = &fine;
+        }
+        const HalfEdgeMesh& fine = *coarse;
+
+        // write out the kept faces' verts that no earlier cluster wrote, then the faces
+        const uint64_t unwritten = ~uint64_t(0);
+        std::vector<uint64_t> written(fine.numVertices(), unwritten);
+        std::vector<glm::vec3> positions;
+        auto outputIndex = [&](MeshIndex v) {
+            if (written[v] != unwritten) return written[v];
+            const VertexTag& tag = tags[v];
+            uint64_t key = 0;
+            MeshIndex users = 0;
+            if (tag.kind == Ancestor::Vertex && vertClusters[tag.id] > 1) {
+                key = tag.id;
+                users = vertClusters[tag.id] - 1;
+            } else if (tag.kind == Ancestor::Edge && edgeOnBorder(tag.id)) {
+                key = base.numVertices() + (uint64_t(tag.id) << levels) + tag.t;
+                users = 1;
+            }
+            if (users > 0) {
+                auto found = shared.find(key);
+                if (found != shared.end()) {
+                    written[v] = found->second.index;
+                    if (--found->second.usersLeft == 0) shared.erase(found);
+                    return written[v];
+                }
+            }
+            written[v] = numWritten + positions.size();
+            positions.push_back(fine.position(v));
+            if (users > 0) shared.emplace(key, SharedVert{written[v], users});
+            return written[v];
+        };
+
+        std::vector<uint64_t> corners(std::size_t(sides) * numKept);
+        std::size_t corner = 0;
+        for (MeshIndex f = 0; f < numKept; ++f) {
+            for (MeshIndex v : faceVertices(fine, f)) {
+                corners[corner++] = outputIndex(v);
+            }
+        }
+        if (!sink.addVertices(positions.data(), positions.size())) return false;
+        if (!sink.addFaces(corners.data(), numKept, sides)) return false;
+        numWritten += positions.size();
+    }
+    if (progress) progress->report(1.0f);
+    return true;
+}
+
+bool StreamingSubdivision::writeOBJ(const HalfEdgeMesh& base, const Options& options, const std::string& filePath,
+                                    LoadProgress* progress) {
+    const std::string tempPath = filePath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not write OBJ file." << std::endl;
+        return false;
+    }
+    ObjWriter writer(out);
+    bool written = subdivide(base, options, writer, progress) && writer.flush();
+    out.close();
+
+    std::error_code fsError;
+    written = written && !out.fail();
+    if (written) std::filesystem::rename(tempPath, filePath, fsError);
+    if (!written || fsError) {
+        if (!progress || !progress->isCancelled()) std::cerr << "Error: Could not write OBJ file." << std::endl;
+        std::filesystem::remove(tempPath, fsError);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef STREAMINGSUBDIVISION_H
+#define STREAMINGSUBDIVISION_H
+
+#include "halfedgemesh.h"
+#include "loadprogress.h"
+#include "subdivisionhierarchy.h"
+#include <cstdint>
+#include <string>
+
+// Receives a streamed fine mesh piece by piece. Verts are numbered in the order
+// they're added, and a face only ever uses verts added before it.
+class SubdivisionSink {
+public:
+    virtual ~SubdivisionSink() = default;
+
+    virtual bool addVertices(const glm::vec3* positions, std::size_t count) = 0;
+    //count faces of sides corners each, corners[sides * i + j] is a 0-based vert number
+    virtual bool addFaces(const uint64_t* corners, std::size_t count, int sides) = 0;
+};
+
+// Uniform subdivision to levels that don't fit in memory. The base is cut into
+// clusters of faces that each refine to at most clusterFaces fine faces, and
+// every cluster is refined on its own: its faces plus one ring of halo faces
+// around them are copied into a submesh and subdivided levels times. A fine
+// face's position only depends on its base face's one ring, so the children of
+// the cluster's own faces come out exactly as refining the whole base would put
+// them; the halo's children are dropped. Only the base, one cluster's levels and
+// the verts shared along cluster borders are held at once.
+//
+// Fine verts on a cluster border are written by the first cluster that reaches
+// them and reused by the others, keyed on the base vert or the base edge (and
+// dyadic position along it) they descend from. A key is dropped once every
+// cluster around it has used it, so the shared set stays a front between the
+// clusters done and those to come rather than growing with the output.
+//
+// Clusters are grown breadth first over the base's faces, so they're compact and
+// their borders short; the submesh refinement itself is the parallel
+// CatmullClark or LoopSubdivision.
+class StreamingSubdivision {
+public:
+    struct Options {
+        int levels = 1;
+        SubdivisionScheme scheme = SubdivisionScheme::CatmullClark; //Loop falls back on non-triangle bases
+        uint64_t clusterFaces = uint64_t(1) << 21; //fine faces per cluster, bounds the memory used
+    };
+
+    //stream base refined options.levels times into sink. Returns false when the
+    //sink fails or progress is cancelled
+    static bool subdivide(const HalfEdgeMesh& base, const Options& options, SubdivisionSink& sink,
+                          LoadProgress* progress = nullptr);
+
+    //subdivide into an OBJ file, written next to filePath and renamed over it
+    static bool writeOBJ(const HalfEdgeMesh& base, const Options& options, const std::string& filePath,
+                         LoadProgress* progress = nullptr);
+};
+
+#endif // STREAMINGSUBDIVISION_H
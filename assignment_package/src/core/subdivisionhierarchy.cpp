@@ -0,0 +1,61 @@
+#include "subdivisionhierarchy.h"
+#include "catmullclark.h"
+#include "loopsubdivision.h"
+
+SubdivisionHierarchy::SubdivisionHierarchy(const HalfEdgeMesh& base)
+    : base(base) {}
+
+const HalfEdgeMesh& SubdivisionHierarchy::level(int k) {
+    if (k == 0) return base;
+    if (numLevels() < k) levels.resize(k); //the only resize, before any reference is taken
+
+    Level& fine = levels[k - 1];
+    if (!fine.built) {
+        // refine from the level below (evaluated first, its positions seed ours)
+        const HalfEdgeMesh& coarse = level(k - 1);
+        StencilTable local;
+        if (refineScheme != SubdivisionScheme::Loop || !LoopSubdivision::subdivideWithStencils(coarse, fine.mesh, local)) {
+            local = CatmullClark::subdivideWithStencils(coarse, fine.mesh);
+        }
+        fine.stencils = k == 1 ? std::move(local) : local.composedWith(levels[k - 2].stencils);
+        fine.built = true;
+    } else if (!fine.current) {
+        fine.stencils.apply(base.positionData(), fine.mesh.positionData());
+    }
+    fine.current = true;
+    return fine.mesh;
+}
+
+bool SubdivisionHierarchy::isBuilt(int k) const {
+    return k == 0 || (k <= numLevels() && levels[k - 1].built);
+}
+
+bool SubdivisionHierarchy::isCurrent(int k) const {
+    return k == 0 || (k <= numLevels() && levels[k - 1].current);
+}
+
+void SubdivisionHierarchy::positionsChanged() {
+    for (Level& fine : levels) {
+        fine.current = false;
+    }
+}
+
+void SubdivisionHierarchy::topologyChanged() {
+    levels.clear();
+}
+
+void SubdivisionHierarchy::setScheme(SubdivisionScheme scheme) {
+    if (scheme == refineScheme) return;
+    refineScheme = scheme;
+    levels.clear();
+}
+
+void SubdivisionHierarchy::release(int k) {
+    if (k < 1 || k > numLevels()) return;
+    levels[k - 1] = Level();
+
+    // trailing released levels don't need a slot
+    while (!levels.empty() && !levels.back().built) {
+        levels.pop_back();
+    }
+}
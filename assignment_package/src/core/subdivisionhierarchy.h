@@ -0,0 +1,58 @@
+#ifndef SUBDIVISIONHIERARCHY_H
+#define SUBDIVISIONHIERARCHY_H
+
+#include "halfedgemesh.h"
+#include "stenciltable.h"
+#include <vector>
+
+enum class SubdivisionScheme {
+    CatmullClark,
+    Loop, //triangle bases only
+};
+
+// Catmull-Clark (or Loop) refinement levels over a base mesh that is edited in place and
+// never overwritten. Level k (k >= 1) is refined from level k - 1 the first
+// time it's asked for, together with a stencil table making each of its verts
+// out of the base's verts (the per-level tables composed down to the base).
+//
+// Edits only ever happen on the base, so they invalidate from level 1 up:
+// moved verts just mark every level stale, and a stale level re-runs its
+// stencils when it's next asked for; a topology change drops every level.
+// Any level can be released to free its memory and is rebuilt on demand.
+// Loop keeps a triangle base all triangles; a base with any other face is
+// refined with Catmull-Clark whatever the scheme.
+class SubdivisionHierarchy {
+public:
+    explicit SubdivisionHierarchy(const HalfEdgeMesh& base);
+
+    //level 0 is the base itself. Refines or re-evaluates whatever level k is
+    //missing; the reference stays valid until the hierarchy is next changed
+    const HalfEdgeMesh& level(int k);
+
+    bool isBuilt(int k) const; //has topology, possibly with stale positions
+    bool isCurrent(int k) const; //built and evaluated from the base's current positions
+    int numLevels() const { return static_cast<int>(levels.size()); } //highest level ever asked for
+
+    //tell the hierarchy its base was edited
+    void positionsChanged();
+    void topologyChanged();
+
+    void release(int k); //free level k (k >= 1)
+
+    void setScheme(SubdivisionScheme scheme); //drops every level when it changes
+    SubdivisionScheme scheme() const { return refineScheme; }
+
+private:
+    struct Level {
+        HalfEdgeMesh mesh;
+        StencilTable stencils; //base verts -> this level's verts
+        bool built = false;
+        bool current = false;
+    };
+
+    const HalfEdgeMesh& base;
+    std::vector<Level> levels; //levels[k - 1] is level k
+    SubdivisionScheme refineScheme = SubdivisionScheme::CatmullClark;
+};
+
+#endif // SUBDIVISIONHIERARCHY_H
@@ -1,9 +1,16 @@
 #include "drawable.h"
+#include <algorithm>
 
 Drawable::Drawable(OpenGLContext *context)
     : glContext(context),
       bufferHandles(),
-      indexBufferLength(-1)
+      textureHandles(),
+      bufferCapacities(),
+      indexBufferLength(-1),
+      vertexLayout(separateLayout()),
+      positionDequantization(1.f),
+      vertexArray(0),
+      vertexArrayCurrent(false)
 {}
 
 Drawable::~Drawable()
@@ -15,6 +22,17 @@ void Drawable::destroyGPUData() {
     for(auto &kvp : bufferHandles) {
         glContext->glDeleteBuffers(1, &kvp.second);
     }
+    for(auto &kvp : textureHandles) {
+        glContext->glDeleteTextures(1, &kvp.second);
+    }
+    bufferHandles.clear();
+    textureHandles.clear();
+    bufferCapacities.clear();
+    if(vertexArray != 0) {
+        glContext->glDeleteVertexArrays(1, &vertexArray);
+        vertexArray = 0;
+    }
+    vertexArrayCurrent = false;
     indexBufferLength = 0;
 }
 
@@ -23,8 +41,26 @@ GLenum Drawable::drawMode() {
 }
 
 void Drawable::generateBuffer(BufferType t) {
+    if(bufferHandles.contains(t)) {
+        return; // reused, bufferData decides whether its storage is
+    }
     bufferHandles[t] = 0; // placeholder, just inserts a kvp into the map
     glContext->glGenBuffers(1, &(bufferHandles.at(t)));
+    bufferCapacities[t] = 0;
+    vertexArrayCurrent = false;
+}
+
+void Drawable::releaseBuffer(BufferType t) {
+    if(bufferHandles.contains(t)) {
+        glContext->glDeleteBuffers(1, &bufferHandles.at(t));
+        bufferHandles.erase(t);
+        bufferCapacities.erase(t);
+        vertexArrayCurrent = false;
+    }
+    if(textureHandles.contains(t)) {
+        glContext->glDeleteTextures(1, &textureHandles.at(t));
+        textureHandles.erase(t);
+    }
 }
 
 void Drawable::bindBuffer(BufferType t) {
@@ -32,17 +68,104 @@ void Drawable::bindBuffer(BufferType t) {
         glContext->glBindBuffer(GL_ARRAY_BUFFER, bufferHandles.at(t));
     }
     else {
+        if(vertexArray == 0) {
+            glContext->glGenVertexArrays(1, &vertexArray);
+        }
+        glContext->glBindVertexArray(vertexArray);
         glContext->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferHandles.at(t));
     }
 }
 
+void Drawable::bindVertexArray() {
+    if(vertexArray == 0) {
+        glContext->glGenVertexArrays(1, &vertexArray);
+    }
+    glContext->glBindVertexArray(vertexArray);
+    if(vertexArrayCurrent) {
+        return;
+    }
+
+    // Drop what an earlier layout enabled, then record the current one
+    for(GLuint a = 0; a < NUM_VERTEX_ATTRIBS; ++a) {
+        glContext->glDisableVertexAttribArray(a);
+    }
+    for(const VertexAttribute &attrib : vertexLayout) {
+        if(!hasBuffer(attrib.buffer)) {
+            continue;
+        }
+        bindBuffer(attrib.buffer);
+        glContext->glEnableVertexAttribArray(attrib.attrib);
+        glContext->glVertexAttribPointer(attrib.attrib, attrib.size, attrib.type, attrib.normalized,
+                                         attrib.stride, reinterpret_cast<const void*>(attrib.offset));
+    }
+    if(hasBuffer(INDEX)) {
+        glContext->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferHandles.at(INDEX));
+    }
+    vertexArrayCurrent = true;
+}
+
+void Drawable::setVertexLayout(const std::vector<VertexAttribute> &layout) {
+    if(layout != vertexLayout) {
+        vertexLayout = layout;
+        vertexArrayCurrent = false;
+    }
+}
+
 bool Drawable::hasBuffer(BufferType t) const {
     return bufferHandles.contains(t);
 }
 
+void Drawable::bufferBytes(BufferType t, const void *data, std::size_t size, GLenum usage) {
+    GLenum target = (t == INDEX ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER);
+    std::size_t &capacity = bufferCapacities.at(t);
+    if(size > capacity) {
+        capacity = std::max(size, capacity + capacity / 2);
+        glContext->glBufferData(target, capacity, nullptr, usage);
+    }
+    else if(size < capacity / 4) {
+        capacity = size;
+        glContext->glBufferData(target, capacity, nullptr, usage);
+    }
+    if(size > 0) {
+        glContext->glBufferSubData(target, 0, size, data);
+    }
+}
+
+void Drawable::bufferTexture(BufferType t, GLenum internalFormat) {
+    if(!textureHandles.contains(t)) {
+        textureHandles[t] = 0;
+        glContext->glGenTextures(1, &(textureHandles.at(t)));
+    }
+    glContext->glBindTexture(GL_TEXTURE_BUFFER, textureHandles.at(t));
+    glContext->glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, bufferHandles.at(t));
+}
+
+void Drawable::bindTexture(BufferType t, GLuint unit) {
+    glContext->glActiveTexture(GL_TEXTURE0 + unit);
+    glContext->glBindTexture(GL_TEXTURE_BUFFER, textureHandles.at(t));
+}
+
 int Drawable::getIndexBufferLength() const {
     return indexBufferLength;
 }
 
+const std::vector<VertexAttribute>& Drawable::getVertexLayout() const {
+    return vertexLayout;
+}
+
+const glm::mat4& Drawable::getPositionDequantization() const {
+    return positionDequantization;
+}
 
+std::vector<VertexAttribute> Drawable::separateLayout() {
+    return {
+        {VS_POS, POSITION, 3, GL_FLOAT, false, 0, 0},
+        {VS_NOR, NORMAL, 3, GL_FLOAT, false, 0, 0},
+        {VS_COL, COLOR, 3, GL_FLOAT, false, 0, 0},
+    };
+}
 
+const char *vertexAttribName(VertexAttrib a) {
+    static const char *const names[NUM_VERTEX_ATTRIBS] = {"vs_Pos", "vs_Nor", "vs_Col", "vs_OctNor"};
+    return names[a];
+}
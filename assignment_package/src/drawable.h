@@ -2,10 +2,39 @@
 
 #include "openglcontext.h"
 #include <la.h>
+#include <string>
+#include <vector>
 
 enum BufferType {
     POSITION, NORMAL, COLOR,
-    INDEX
+    INDEX,
+    // read by shaders through buffer textures rather than as attributes
+    FACE_COLOR,   // one RGBA8 texel per face
+    TRIANGLE_FACE, // the face each triangle of the index buffer belongs to
+    VERTEX        // several attributes interleaved, as a vertex layout describes
+};
+
+// The vertex shader `in` variables a drawable can supply. Every ShaderProgram
+// binds them to these locations before linking, so the bindings a drawable's
+// VAO records work with whichever program draws it.
+enum VertexAttrib : GLuint {
+    VS_POS, VS_NOR, VS_COL,
+    VS_OCT_NOR, // a normal folded onto the octahedron, 2 components
+    NUM_VERTEX_ATTRIBS
+};
+const char *vertexAttribName(VertexAttrib a); // as written in the shaders, e.g. vs_Pos
+
+// Where the data of one VertexAttrib lives in a drawable's buffers.
+struct VertexAttribute {
+    VertexAttrib attrib;
+    BufferType buffer;
+    GLint size;         // components per vertex
+    GLenum type;        // e.g. GL_FLOAT, or GL_UNSIGNED_SHORT for quantized data
+    bool normalized;    // integer types are read as [0, 1] (or [-1, 1] if signed)
+    GLsizei stride;     // bytes from one vertex to the next, 0 if tightly packed
+    std::size_t offset; // bytes from the start of the buffer to the first vertex
+
+    bool operator==(const VertexAttribute &other) const = default;
 };
 
 class Drawable {
@@ -14,6 +43,8 @@ protected:
     OpenGLContext *glContext;
 
     std::unordered_map<BufferType, GLuint> bufferHandles;
+    std::unordered_map<BufferType, GLuint> textureHandles; // buffer textures over FACE_COLOR and TRIANGLE_FACE
+    std::unordered_map<BufferType, std::size_t> bufferCapacities; // bytes allocated for each buffer
 
     // We will store the number of indices that we send to our
     // index buffer. For example, if the index buffer was
@@ -23,6 +54,18 @@ protected:
     // drawing our geometry.
     int indexBufferLength;
 
+    // How the shaders read this drawable's buffers, and the matrix taking
+    // vs_Pos into model space (the identity unless positions are quantized).
+    std::vector<VertexAttribute> vertexLayout;
+    glm::mat4 positionDequantization;
+    void setVertexLayout(const std::vector<VertexAttribute> &layout);
+
+    // Records vertexLayout's attribute bindings and the INDEX buffer. It's
+    // only set up again after the layout or a buffer handle changes;
+    // reallocating a buffer's storage keeps its handle.
+    GLuint vertexArray;
+    bool vertexArrayCurrent;
+
 public:
     Drawable(OpenGLContext*);
     virtual ~Drawable();
@@ -39,16 +82,53 @@ public:
     // You can write subclasses that return GL_LINES or GL_POINTS.
     virtual GLenum drawMode();
 
+    // Buffers persist across uploads: generateBuffer only creates t's
+    // buffer the first time, and releaseBuffer deletes it for drawables
+    // that stop using it.
     void generateBuffer(BufferType t);
+    void releaseBuffer(BufferType t);
+    // Binding INDEX binds this drawable's VAO first, since the VAO is what
+    // holds the element array binding.
     void bindBuffer(BufferType t);
     bool hasBuffer(BufferType t) const;
+    // Bind the VAO, recording the attribute bindings first if they changed.
+    // All ShaderProgram::draw needs before glDrawElements.
+    void bindVertexArray();
 
+    // Upload into the bound buffer of type t. Its storage is only
+    // reallocated when the data outgrows it (then with half again as much
+    // room) or would use less than a quarter of it; otherwise the data is
+    // written in place. Pass GL_DYNAMIC_DRAW for buffers that are rewritten
+    // or patched while they're drawn.
     template<class T>
-    void bufferData(BufferType t, const std::vector<T> &data) {
+    void bufferData(BufferType t, const T *data, std::size_t count, GLenum usage = GL_STATIC_DRAW) {
+        bufferBytes(t, data, count * sizeof(T), usage);
+    }
+    template<class T>
+    void bufferData(BufferType t, const std::vector<T> &data, GLenum usage = GL_STATIC_DRAW) {
+        bufferData(t, data.data(), data.size(), usage);
+    }
+    void bufferBytes(BufferType t, const void *data, std::size_t size, GLenum usage);
+    // Overwrite count elements of the bound buffer of type t, starting at
+    // element first, without reallocating it.
+    template<class T>
+    void bufferSubData(BufferType t, std::size_t first, const T *data, std::size_t count) {
         GLenum target = (t == INDEX ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER);
-        glContext->glBufferData(target, data.size() * sizeof(T), data.data(), GL_STATIC_DRAW);
+        glContext->glBufferSubData(target, first * sizeof(T), count * sizeof(T), data);
     }
 
+    // Expose the buffer of type t to shaders as a samplerBuffer
+    // (or usamplerBuffer) whose texels have the given internal format.
+    void bufferTexture(BufferType t, GLenum internalFormat);
+    // Bind t's buffer texture to the given texture unit.
+    void bindTexture(BufferType t, GLuint unit);
+
 
     int getIndexBufferLength() const;
+    const std::vector<VertexAttribute>& getVertexLayout() const;
+    const glm::mat4& getPositionDequantization() const;
+
+    // The default layout: float vec3 POSITION, NORMAL and COLOR buffers,
+    // read as vs_Pos, vs_Nor and vs_Col.
+    static std::vector<VertexAttribute> separateLayout();
 };
@@ -1,5 +1,8 @@
 #include "mainwindow.h"
 #include <ui_mainwindow.h>
+#include <QtConcurrent/QtConcurrentRun>
+#include "core/limitevaluator.h"
+#include "core/streamingsubdivision.h"
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -14,9 +17,26 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->faceRedSpinBox, SIGNAL(valueChanged(double)), this, SLOT(onFaceColorChanged()));
     connect(ui->faceGreenSpinBox, SIGNAL(valueChanged(double)), this, SLOT(onFaceColorChanged()));
     connect(ui->faceBlueSpinBox, SIGNAL(valueChanged(double)), this, SLOT(onFaceColorChanged()));
+
+    connect(&meshLoadWatcher, SIGNAL(finished()), this, SLOT(onMeshLoadFinished()));
+    connect(&exportWatcher, SIGNAL(finished()), this, SLOT(onExportFinished()));
+    connect(&loadProgressTimer, SIGNAL(timeout()), this, SLOT(onMeshLoadProgress()));
+
+    // the lists read their labels from the mesh's models, which follow every loaded mesh
+    ui->vertsListView->setModel(ui->mygl->my_mesh.vertexList());
+    ui->facesListView->setModel(ui->mygl->my_mesh.faceList());
+    ui->halfEdgesListView->setModel(ui->mygl->my_mesh.halfEdgeList());
 }
 
 MainWindow::~MainWindow() {
+    if (meshLoadWatcher.isRunning()) { //the worker writes into stagingMesh, let it stop first
+        loadProgress->cancel();
+        meshLoadWatcher.waitForFinished();
+    }
+    if (exportWatcher.isRunning()) { //the worker still reports into loadProgress
+        loadProgress->cancel();
+        exportWatcher.waitForFinished();
+    }
     delete ui;
 }
 
@@ -28,94 +48,216 @@ void MainWindow::on_openOBJ_clicked() {
     // open file dialog for selecting an OBJ file
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     tr("Open OBJ File"), "",
-                                                    tr("OBJ Files (*.obj);;All Files (*)"));
+                                                    tr("Mesh Files (*.obj *.heds);;OBJ Files (*.obj);;Half-Edge Files (*.heds);;All Files (*)"));
+
+    // check if a file was selected (only one load or export runs at a time)
+    if (fileName.isEmpty() || meshLoadWatcher.isRunning() || exportWatcher.isRunning()) return;
+
+    // load into a staging mesh on a worker thread; the current mesh stays usable
+    stagingMesh = std::make_unique<HalfEdgeMesh>(TwinLayout::Paired);
+    loadProgress = std::make_unique<LoadProgress>();
+    loadingFileName = fileName;
+    openProgressDialog(tr("Loading %1...").arg(QFileInfo(fileName).fileName()));
+
+    HalfEdgeMesh* mesh = stagingMesh.get();
+    LoadProgress* progress = loadProgress.get();
+    meshLoadWatcher.setFuture(QtConcurrent::run([mesh, progress, fileName] {
+        return Mesh::loadKernel(*mesh, fileName, progress);
+    }));
+    loadProgressTimer.start(50);
+}
+
+//subdivide the cage further than fits in memory, streaming the result into an OBJ file
+void MainWindow::on_actionExportSubdivided_triggered() {
+    if (meshLoadWatcher.isRunning() || exportWatcher.isRunning()) return;
+
+    bool ok = false;
+    int levels = QInputDialog::getInt(this, tr("Export Subdivided OBJ"), tr("Subdivision levels:"), 4, 1, 16, 1, &ok);
+    if (!ok) return;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Subdivided OBJ"), "", tr("OBJ Files (*.obj)"));
+    if (fileName.isEmpty()) return;
 
-    // check if a file was selected
-    if (!fileName.isEmpty()) {
+    StreamingSubdivision::Options options;
+    options.levels = levels;
+    options.scheme = ui->actionLoop->isChecked() ? SubdivisionScheme::Loop : SubdivisionScheme::CatmullClark;
+    loadProgress = std::make_unique<LoadProgress>();
+    loadingFileName = fileName;
+    exportTitle = tr("Export Subdivided OBJ");
+    openProgressDialog(tr("Writing %1...").arg(QFileInfo(fileName).fileName()));
 
-        // load OBJ file
-        ui->mygl->my_mesh.loadOBJ(fileName);
+    // the window stays live until the dialog shows up, and the cage can be edited
+    // under it, so the worker refines its own copy
+    auto base = std::make_shared<const HalfEdgeMesh>(ui->mygl->my_mesh.kernel());
+    LoadProgress* progress = loadProgress.get();
+    std::string filePath = fileName.toStdString();
+    exportWatcher.setFuture(QtConcurrent::run([base, options, filePath, progress] {
+        return StreamingSubdivision::writeOBJ(*base, options, filePath, progress);
+    }));
+    loadProgressTimer.start(50);
+}
+
+//refine the cage uniformly with every vert moved onto the Catmull-Clark limit
+//surface, written with the limit normals
+void MainWindow::on_actionExportLimit_triggered() {
+    if (meshLoadWatcher.isRunning() || exportWatcher.isRunning()) return;
+
+    bool ok = false;
+    int levels = QInputDialog::getInt(this, tr("Export Limit Surface OBJ"), tr("Subdivision levels:"), 3, 1, 6, 1, &ok);
+    if (!ok) return;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export Limit Surface OBJ"), "", tr("OBJ Files (*.obj)"));
+    if (fileName.isEmpty()) return;
 
-        ui->mygl->meshLoaded = true; //set meshLoaded as true so PaintGL() will paint our mesh
-        ui->mygl->m_vertDisplay.representedVertex = nullptr; //reset selected mesh components
-        ui->mygl->m_faceDisplay.representedFace = nullptr; //reset selected mesh components
-        ui->mygl->m_HEDisplay.representedHE = nullptr; //reset selected mesh components
+    loadProgress = std::make_unique<LoadProgress>();
+    loadingFileName = fileName;
+    exportTitle = tr("Export Limit Surface OBJ");
+    openProgressDialog(tr("Writing %1...").arg(QFileInfo(fileName).fileName()));
+
+    auto base = std::make_shared<const HalfEdgeMesh>(ui->mygl->my_mesh.kernel());
+    LoadProgress* progress = loadProgress.get();
+    std::string filePath = fileName.toStdString();
+    exportWatcher.setFuture(QtConcurrent::run([base, levels, filePath, progress] {
+        return LimitEvaluator(*base).writeOBJ(levels, filePath, progress);
+    }));
+    loadProgressTimer.start(50);
+}
 
-        // populate list widgets
-        ui->mygl->my_mesh.setListWidgets(ui->vertsListWidget, ui->facesListWidget, ui->halfEdgesListWidget);
+void MainWindow::onExportFinished() {
+    loadProgressTimer.stop();
+    closeProgressDialog();
+    if (!loadProgress->isCancelled() && !exportWatcher.result()) {
+        QMessageBox::warning(this, exportTitle, tr("Could not write %1.").arg(loadingFileName));
     }
+    loadProgress.reset();
 }
 
-//UPDATE CLICKED QLIST ITEMS
-void MainWindow::on_vertsListWidget_itemClicked(QListWidgetItem *item) {
-    ui->mygl->m_vertDisplay.updateVertex(dynamic_cast<Vertex*>(item));
+void MainWindow::openProgressDialog(const QString& label) {
+    loadDialog = new QProgressDialog(label, tr("Cancel"), 0, 100, this);
+    loadDialog->setWindowModality(Qt::WindowModal);
+    loadDialog->setMinimumDuration(250); //quick runs finish before the dialog shows up
+    loadDialog->setAutoReset(false);
+    connect(loadDialog, &QProgressDialog::canceled, this, [this] { loadProgress->cancel(); });
 }
 
+void MainWindow::closeProgressDialog() {
+    loadDialog->disconnect(this); //closing the dialog emits canceled()
+    loadDialog->close();
+    loadDialog->deleteLater();
+    loadDialog = nullptr;
+}
 
-void MainWindow::on_halfEdgesListWidget_itemClicked(QListWidgetItem *item) {
-    ui->mygl->m_HEDisplay.updateHE(dynamic_cast<HalfEdge*>(item));
+void MainWindow::onMeshLoadProgress() {
+    if (loadDialog && !loadProgress->isCancelled()) {
+        loadDialog->setValue(static_cast<int>(100.0f * loadProgress->fraction()));
+    }
 }
 
+//runs on the GUI thread once the worker is done: swap the staging mesh in and upload it
+void MainWindow::onMeshLoadFinished() {
+    loadProgressTimer.stop();
+    closeProgressDialog();
+
+    // a cancelled load keeps the previous mesh on screen
+    bool cancelled = loadProgress->isCancelled();
+    if (!cancelled && meshLoadWatcher.result()) {
+        ui->mygl->setMesh(std::move(*stagingMesh));
+    } else if (!cancelled) {
+        QMessageBox::warning(this, tr("Open Mesh"), tr("Could not load %1.").arg(loadingFileName));
+    }
+    stagingMesh.reset();
+    loadProgress.reset();
+}
 
-void MainWindow::on_facesListWidget_itemClicked(QListWidgetItem *item) {
-    ui->mygl->m_faceDisplay.updateFace(dynamic_cast<Face*>(item));
+//UPDATE CLICKED QLIST ITEMS, every row is the kernel index it's labelled with
+void MainWindow::on_vertsListView_clicked(const QModelIndex &index) {
+    ui->mygl->selectVertex(index.row());
 }
 
-//SLOTS TO CONNECT KEYPRESSEVENTS--delete
-void MainWindow::updateHalfEdgeDisplay(HalfEdge* selectedHalfEdge) {}
 
-void MainWindow::updateFaceDisplay(Face* selectedFace) {}
+void MainWindow::on_halfEdgesListView_clicked(const QModelIndex &index) {
+    ui->mygl->selectHalfEdge(index.row());
+}
+
 
-void MainWindow::updateVertexDisplay(Vertex* selectedVertex) {}
+void MainWindow::on_facesListView_clicked(const QModelIndex &index) {
+    ui->mygl->selectFace(index.row());
+}
 
 
 //SUBDIVISION BUTTONS
 void MainWindow::on_splitEdge_clicked()
 {
-    ui->mygl->my_mesh.splitEdge(ui->mygl->m_HEDisplay.representedHE, ui->vertsListWidget, ui->halfEdgesListWidget);
-    ui->mygl->m_HEDisplay.initializeAndBufferGeometryData(); //update HE display
-    ui->mygl->m_vertDisplay.initializeAndBufferGeometryData(); //update vert display
+    ui->mygl->my_mesh.splitEdge(ui->mygl->m_HEDisplay.representedHE);
+    ui->mygl->meshEdited(); //update mesh drawing and the selection
 }
 
+//show the next subdivision level; the cage stays editable, keys 0-3 step back to it
 void MainWindow::on_subdivide_clicked()
 {
-    ui->mygl->my_mesh.catmullClarkSubdivide(ui->vertsListWidget, ui->facesListWidget, ui->halfEdgesListWidget);
-    ui->mygl->my_mesh.initializeAndBufferGeometryData();
-    ui->mygl->m_HEDisplay.initializeAndBufferGeometryData(); //update HE display
-    ui->mygl->m_vertDisplay.initializeAndBufferGeometryData(); //update vert display
-    ui->mygl->m_faceDisplay.initializeAndBufferGeometryData(); //update face display
+    ui->mygl->showLevel(ui->mygl->my_mesh.shownLevel() + 1);
+}
+
+//make the shown level the cage, so its own elements can be edited
+void MainWindow::on_actionApplyLevel_triggered()
+{
+    ui->mygl->my_mesh.applyShownLevel();
+    ui->mygl->meshEdited();
+}
 
+void MainWindow::on_actionReleaseLevels_triggered()
+{
+    ui->mygl->releaseHiddenLevels();
 }
 
-void MainWindow::on_pushButton_clicked() //to triangulate face
+//refine only around extraordinary verts and non-quads, regular regions are drawn as patches
+void MainWindow::on_actionAdaptive_toggled(bool checked)
+{
+    ui->mygl->setAdaptive(checked);
+}
+
+//refine only the faces selected in the list (shift/ctrl-click to pick several)
+void MainWindow::on_actionSubdivideSelection_triggered()
+{
+    std::vector<MeshIndex> selected;
+    for (const QModelIndex& index : ui->facesListView->selectionModel()->selectedIndexes()) {
+        selected.push_back(index.row());
+    }
+    ui->mygl->my_mesh.subdivideFaces(selected);
+    ui->mygl->meshEdited();
+}
+
+//refine triangle meshes into triangles; other meshes stay Catmull-Clark
+void MainWindow::on_actionLoop_toggled(bool checked)
 {
-    ui->mygl->my_mesh.triangulateFace(ui->mygl->m_faceDisplay.representedFace, ui->facesListWidget, ui->halfEdgesListWidget);
-    ui->mygl->my_mesh.initializeAndBufferGeometryData();
-    ui->mygl->m_faceDisplay.initializeAndBufferGeometryData(); //update face display
+    ui->mygl->setScheme(checked ? SubdivisionScheme::Loop : SubdivisionScheme::CatmullClark);
+}
 
+void MainWindow::on_pushButton_clicked() //to triangulate face
+{
+    ui->mygl->my_mesh.triangulateFace(ui->mygl->m_faceDisplay.representedFace);
+    ui->mygl->meshEdited();
 }
 
 //SPIN BOX SLOTS
 void MainWindow::onVertexPositionChanged() {
-    if (ui->mygl->m_vertDisplay.representedVertex != nullptr) {
-        ui->mygl->m_vertDisplay.representedVertex->position.x = ui->vertPosXSpinBox->value();
-        ui->mygl->m_vertDisplay.representedVertex->position.y = ui->vertPosYSpinBox->value();
-        ui->mygl->m_vertDisplay.representedVertex->position.z = ui->vertPosZSpinBox->value();
-
-        ui->mygl->my_mesh.initializeAndBufferGeometryData(); //update mesh drawing
-        ui->mygl->m_vertDisplay.initializeAndBufferGeometryData(); //update vertex display
-        update();
+    MeshIndex vert = ui->mygl->m_vertDisplay.representedVertex;
+    if (vert != NO_INDEX) {
+        ui->mygl->my_mesh.kernel().setPosition(vert, glm::vec3(ui->vertPosXSpinBox->value(),
+                                                               ui->vertPosYSpinBox->value(),
+                                                               ui->vertPosZSpinBox->value()));
+
+        ui->mygl->vertexMoved(vert);
     }
 }
 
 void MainWindow::onFaceColorChanged() {
-    if (ui->mygl->m_faceDisplay.representedFace != nullptr) {
-        ui->mygl->m_faceDisplay.representedFace->color.r = ui->faceRedSpinBox->value();
-        ui->mygl->m_faceDisplay.representedFace->color.g = ui->faceGreenSpinBox->value();
-        ui->mygl->m_faceDisplay.representedFace->color.b = ui->faceBlueSpinBox->value();
+    MeshIndex face = ui->mygl->m_faceDisplay.representedFace;
+    if (face != NO_INDEX) {
+        ui->mygl->my_mesh.kernel().setFaceColor(face, glm::vec3(ui->faceRedSpinBox->value(),
+                                                                ui->faceGreenSpinBox->value(),
+                                                                ui->faceBlueSpinBox->value()));
 
-        ui->mygl->my_mesh.initializeAndBufferGeometryData();
-        update();
+        ui->mygl->my_mesh.faceColorChanged(face);
+        ui->mygl->update();
     }
 }
 
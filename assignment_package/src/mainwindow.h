@@ -3,9 +3,14 @@
 
 #include <QMainWindow>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QObject>
-#include <QListWidgetItem>
+#include <QModelIndex>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+#include <QTimer>
+#include <memory>
 #include "mesh.h"
 
 namespace Ui {
@@ -21,34 +26,65 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
-public slots:
-    void updateHalfEdgeDisplay(HalfEdge* selectedHalfEdge);
-    void updateFaceDisplay(Face* selectedFace);
-    void updateVertexDisplay(Vertex* selectedVertex);
-
 private slots:
     void on_actionQuit_triggered();
 
     void on_openOBJ_clicked();
 
-    void on_vertsListWidget_itemClicked(QListWidgetItem *item);
+    void on_actionExportSubdivided_triggered();
+
+    void on_actionExportLimit_triggered();
+
+    void on_vertsListView_clicked(const QModelIndex &index);
 
-    void on_halfEdgesListWidget_itemClicked(QListWidgetItem *item);
+    void on_halfEdgesListView_clicked(const QModelIndex &index);
 
-    void on_facesListWidget_itemClicked(QListWidgetItem *item);
+    void on_facesListView_clicked(const QModelIndex &index);
 
     void on_splitEdge_clicked();
 
     void on_subdivide_clicked();
 
+    void on_actionApplyLevel_triggered();
+
+    void on_actionReleaseLevels_triggered();
+
+    void on_actionAdaptive_toggled(bool checked);
+
+    void on_actionLoop_toggled(bool checked);
+
+    void on_actionSubdivideSelection_triggered();
+
     void on_pushButton_clicked();
 
     void onVertexPositionChanged();
 
     void onFaceColorChanged();
 
+    void onMeshLoadFinished();
+
+    void onMeshLoadProgress();
+
+    void onExportFinished();
+
 private:
     Ui::MainWindow *ui;
+
+    //meshes load on a worker thread into stagingMesh, which is swapped into
+    //MyGL's mesh on this thread once the load finishes
+    QFutureWatcher<bool> meshLoadWatcher;
+    std::unique_ptr<HalfEdgeMesh> stagingMesh;
+    std::unique_ptr<LoadProgress> loadProgress;
+    QString loadingFileName;
+    QProgressDialog* loadDialog = nullptr; //only exists while loading or exporting
+    QTimer loadProgressTimer; //polls loadProgress into loadDialog
+
+    //exports refine a copy of the cage on a worker, behind the same dialog
+    QFutureWatcher<bool> exportWatcher;
+    QString exportTitle; //of the export running, for its error message
+
+    void openProgressDialog(const QString& label);
+    void closeProgressDialog();
 };
 
 
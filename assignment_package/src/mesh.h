@@ -2,6 +2,7 @@
 #define MESH_H
 
 #include <vector>
+#include <algorithm>
 #include <memory>
 #include <glm/glm.hpp>
 #include <iostream>
@@ -9,55 +10,93 @@
 #include <sstream>
 #include <random>
 #include <map>
-#include <QListWidget>
-#include <QListWidgetItem>
+#include <QFileInfo>
+#include "core/adaptivesurface.h"
+#include "core/loadprogress.h"
+#include "core/subdivisionhierarchy.h"
 #include "meshcomponents.h"
-#include "drawable.h"
+#include "surfacedrawable.h"
 #include "utils.h"
 #include "mainwindow.h"
 
-struct EdgePairHash {
-    std::size_t operator()(const std::pair<HalfEdge*, HalfEdge*>& edgePair) const {
-        return std::hash<HalfEdge*>()(edgePair.first) ^ std::hash<HalfEdge*>()(edgePair.second);
-    }
-};
-
-class Mesh : public Drawable {
+class Mesh : public SurfaceDrawable {
 public:
     Mesh(OpenGLContext* context);
+    ~Mesh();
 
     //override drawable's funcs
-    void initializeAndBufferGeometryData() override;
-    GLenum drawMode() override;
+    void initializeAndBufferGeometryData() override; //the cage changed, re-buffer the shown level
 
     //load mesh
-    void loadOBJ(const QString &filename);
-    void setListWidgets(QListWidget* vertsWidget, QListWidget* facesWidget, QListWidget* halfEdgesWidget); //populate QListWidgetItems
+    static bool loadKernel(HalfEdgeMesh& kernel, const QString& filename, LoadProgress* progress = nullptr); //safe off the GUI thread
+    void setKernel(HalfEdgeMesh&& loaded); //swap in a kernel loaded elsewhere, the caller re-buffers
+
+    //catmullclark/subdivision operations on cage elements, NO_INDEX does nothing
+    void splitEdge(MeshIndex he);
+    void triangulateFace(MeshIndex f);
+    void subdivideFaces(const std::vector<MeshIndex>& selected); //refine just these faces of the cage
+
+    //subdivision levels over the cage, refined on first show and cached with their
+    //own GPU buffers. Level 0 is the cage itself; these need our GL context current
+    void setShownLevel(int level);
+    int shownLevel() const;
+    Drawable& shownDrawable(); //buffers to draw for the shown level
+    void releaseHiddenLevels(); //free every cached level that isn't shown
+    void applyShownLevel(); //replace the cage with the shown level
+    void setAdaptive(bool adaptive); //show levels as adaptive patches instead of uniform refinement
+    bool isAdaptive() const;
+    void setScheme(SubdivisionScheme scheme); //how uniform levels are refined, adaptive ones are always Catmull-Clark
+
+    //position and colour edits made through the kernel are only marked here, and
+    //the next bufferEdits() patches them into the shown level's buffers in place,
+    //so the spinboxes' ticks cost a few bytes each. Topology edits re-buffer
+    void vertexMoved(MeshIndex v);
+    void faceColorChanged(MeshIndex f);
+    void bufferEdits(); //needs our GL context
 
-    //catmullclark/subdivision operations
-    void splitEdge(HalfEdge* selectedHE, QListWidget* vertsWidget, QListWidget* halfEdgesWidget);
-    void triangulateFace(Face* face, QListWidget* facesWidget, QListWidget* halfEdgesWidget);
-    void catmullClarkSubdivide(QListWidget* vertsWidget, QListWidget* facesWidget, QListWidget* halfEdgesWidget);
+    //access to the Qt-free kernel and the list models naming its elements
+    HalfEdgeMesh& kernel();
+    const HalfEdgeMesh& kernel() const;
+    MeshElementModel* vertexList();
+    MeshElementModel* faceList();
+    MeshElementModel* halfEdgeList();
 
 private:
-    //vectors which hold all mesh's components
-    std::vector<uPtr<Vertex>> vertices;
-    std::vector<uPtr<Face>> faces;
-    std::vector<uPtr<HalfEdge>> halfEdges;
-
-    //member funcs for creating meshcomponenets
-    Vertex* createVertex(const glm::vec3& position);
-    Face* createFace(const glm::vec3& color);
-    HalfEdge* createHalfEdge();
-
-    void setupVBOs(); //helper funcs
-    int countEdgesInFace(Face* face);
-    Vertex* createCentroid(Face* face);
-    std::pair<HalfEdge*, HalfEdge*> makeEdgePair(HalfEdge* he1, HalfEdge* he2);
-    Vertex* createEdgePoint(HalfEdge* he, Vertex* centroid1, Vertex* centroid2, QListWidget* vertsWidget, QListWidget* halfEdgesWidget);
-    void getConnectedEdges(Vertex* v, std::vector<HalfEdge*> *connectedEdges);
-    void getConnectedFaces(Vertex* v, std::vector<Face*> *connectedFaces);
-    void getOriginalHalfEdges(Face* face, std::vector<HalfEdge*> *originalHalfEdges);
+    HalfEdgeMesh core; //holds all of the mesh's positions and connectivity
+
+    //row i of each list is element i of core, labelled on demand
+    MeshElementModel vertexModel;
+    MeshElementModel faceModel;
+    MeshElementModel halfEdgeModel;
+
+    //refined levels over core and the buffers each one was last uploaded to
+    struct LevelView {
+        std::unique_ptr<SurfaceDrawable> drawable;
+        std::unique_ptr<AdaptiveSurface> patches; //adaptive levels only, built from the cage
+        bool current = false; //buffers match the level's current positions and topology
+    };
+    SubdivisionHierarchy hierarchy;
+    std::vector<LevelView> levelViews; //[k] draws level k; the cage (k = 0) uses our own buffers
+    std::vector<LevelView> adaptiveViews; //[k] draws level k adaptively, [0] is unused
+    bool adaptive = false;
+    int shown = 0;
+
+    //cage elements edited since the shown level was last buffered, as the
+    //half-open range spanning all of them
+    struct DirtyRange {
+        MeshIndex begin = NO_INDEX;
+        MeshIndex end = 0;
+        void add(MeshIndex i) { begin = std::min(begin, i); end = std::max(end, i + 1); }
+        bool empty() const { return begin >= end; }
+    };
+    DirtyRange dirtyVerts;
+    DirtyRange dirtyFaces;
+
+    void bufferShownLevel(); //helper funcs
+    void listAddedElements();
+    std::vector<LevelView>& viewsOf(int level); //the views level is drawn from in the current mode
+    void cageTopologyChanged(); //drop every refined level
+    void invalidateLevelViews();
 };
 
 #endif // MESH_H
@@ -1,75 +1,61 @@
 #include "meshcomponents.h"
+#include "core/circulators.h"
 
-// init static member variables
-int Vertex::nextID = 0;
-int Face::nextID = 0;
-int HalfEdge::nextID = 0;
+MeshElementModel::MeshElementModel(const HalfEdgeMesh* mesh, Kind kind, QObject* parent)
+    : QAbstractListModel(parent), mesh(mesh), kind(kind) {}
 
-Vertex::Vertex(const glm::vec3& pos)
-    : QListWidgetItem(), position(pos), edge(nullptr), id(nextID++), isOriginal(true) {}
-
-int Vertex::getID() const {
-    return id;
-}
-
-void Vertex::setHE(HalfEdge* e) {
-    this->edge = e;
-    e->vert = this;
-}
-
-Face::Face(const glm::vec3& col)
-    : QListWidgetItem(), edge(nullptr), color(col), id(nextID++) {}
-
-int Face::getID() const {
-    return id;
-}
-
-void Face::setEdge(HalfEdge* edge) {
-    this->edge = edge;
-    edge->face = this;
-}
-
-HalfEdge::HalfEdge()
-    : QListWidgetItem(), next(nullptr), sym(nullptr), face(nullptr), vert(nullptr), id(nextID++), isOriginal(true) {}
-
-int HalfEdge::getID() const {
-    return id;
+int MeshElementModel::kernelCount() const {
+    switch (kind) {
+        case Vertices: return static_cast<int>(mesh->numVertices());
+        case Faces: return static_cast<int>(mesh->numFaces());
+        default: return static_cast<int>(mesh->numHalfEdges());
+    }
 }
 
-void HalfEdge::setNext(HalfEdge* nextEdge) {
-    this->next = nextEdge;
+int MeshElementModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows; //a list, rows have no children
 }
 
-void HalfEdge::setSym(HalfEdge* symEdge) {
-    this->sym = symEdge;
-    symEdge->sym = this;
+QVariant MeshElementModel::data(const QModelIndex& index, int role) const {
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= rows) return QVariant();
+    switch (kind) {
+        case Vertices: return QString("Vertex %1").arg(index.row());
+        case Faces: return QString("Face %1").arg(index.row());
+        default: return QString("HalfEdge %1").arg(index.row());
+    }
 }
 
-void HalfEdge::setFace(Face* f) {
-    this->face = f;
-    f->edge = this;
+//topology edits only append elements, so existing rows and their selection stay
+void MeshElementModel::elementsAdded() {
+    const int count = kernelCount();
+    if (count <= rows) return;
+    beginInsertRows(QModelIndex(), rows, count - 1);
+    rows = count;
+    endInsertRows();
 }
 
-void HalfEdge::setVertex(Vertex* vertex) {
-    this->vert = vertex;
-    vertex->edge = this;
+void MeshElementModel::elementsReplaced() {
+    beginResetModel();
+    rows = kernelCount();
+    endResetModel();
 }
 
 VertexDisplay::VertexDisplay(OpenGLContext* context)
-    : Drawable(context), representedVertex(nullptr) {}
+    : Drawable(context), mesh(nullptr), representedVertex(NO_INDEX) {}
 
 
-void VertexDisplay::updateVertex(Vertex* v) {
+void VertexDisplay::updateVertex(const HalfEdgeMesh* mesh, MeshIndex v) {
+    this->mesh = mesh;
     representedVertex = v;
     initializeAndBufferGeometryData(); //rebuffer data when new v is selected
 }
 
 void VertexDisplay::initializeAndBufferGeometryData() {
-    if (representedVertex == nullptr) {
+    if (representedVertex == NO_INDEX) {
         return;
     }
 
-    std::vector<glm::vec3> pos = { representedVertex->position }; //hold vertex pos to render as a point
+    std::vector<glm::vec3> pos = { mesh->position(representedVertex) }; //hold vertex pos to render as a point
     std::vector<unsigned int> indices = { 0 };
     std::vector<float> col = { 1, 1, 1 };
 
@@ -77,15 +63,15 @@ void VertexDisplay::initializeAndBufferGeometryData() {
 
     generateBuffer(POSITION);
     bindBuffer(POSITION);
-    bufferData(POSITION, pos);
+    bufferData(POSITION, pos, GL_DYNAMIC_DRAW);
 
     generateBuffer(COLOR);
     bindBuffer(COLOR);
-    bufferData(COLOR, col);
+    bufferData(COLOR, col, GL_DYNAMIC_DRAW);
 
     generateBuffer(INDEX);
     bindBuffer(INDEX);
-    bufferData(INDEX, indices);
+    bufferData(INDEX, indices, GL_DYNAMIC_DRAW);
 }
 
 GLenum VertexDisplay::drawMode() {
@@ -94,34 +80,32 @@ GLenum VertexDisplay::drawMode() {
 }
 
 FaceDisplay::FaceDisplay(OpenGLContext* context)
-    : Drawable(context), representedFace(nullptr) {}
+    : Drawable(context), mesh(nullptr), representedFace(NO_INDEX) {}
 
-void FaceDisplay::updateFace(Face* f) {
+void FaceDisplay::updateFace(const HalfEdgeMesh* mesh, MeshIndex f) {
+    this->mesh = mesh;
     representedFace = f;
     initializeAndBufferGeometryData(); // rebuffer geometry data when face is updated
 }
 
 void FaceDisplay::initializeAndBufferGeometryData() {
-    if (representedFace == nullptr) {
+    if (representedFace == NO_INDEX) {
         return;
     }
 
     std::vector<glm::vec3> pos; // To store n vertex positions for n-gon
-    HalfEdge* start = representedFace->edge;
-    HalfEdge* current = start;
 
     // traverse all half-edges of the face to collect vertex positions
-    do {
-        pos.push_back(current->vert->position);
-        current = current->next;
-    } while (current != start);
+    for (MeshIndex v : faceVertices(*mesh, representedFace)) {
+        pos.push_back(mesh->position(v));
+    }
 
     std::vector<unsigned int> indices(pos.size());
     for (unsigned int i = 0; i < indices.size(); ++i) {
         indices[i] = i; // index setup for the n-gon
     }
 
-    glm::vec3 faceColor = representedFace->color;
+    glm::vec3 faceColor = mesh->faceColor(representedFace);
     glm::vec3 outlineColor = glm::vec3(1.0f) - faceColor;
     std::vector<glm::vec3> colors(pos.size(), outlineColor);
 
@@ -130,15 +114,15 @@ void FaceDisplay::initializeAndBufferGeometryData() {
     // buffer vertex data
     generateBuffer(POSITION);
     bindBuffer(POSITION);
-    bufferData(POSITION, pos);
+    bufferData(POSITION, pos, GL_DYNAMIC_DRAW);
 
     generateBuffer(COLOR);
     bindBuffer(COLOR);
-    bufferData(COLOR, colors);
+    bufferData(COLOR, colors, GL_DYNAMIC_DRAW);
 
     generateBuffer(INDEX);
     bindBuffer(INDEX);
-    bufferData(INDEX, indices);
+    bufferData(INDEX, indices, GL_DYNAMIC_DRAW);
 }
 
 GLenum FaceDisplay::drawMode() {
@@ -146,22 +130,23 @@ GLenum FaceDisplay::drawMode() {
 }
 
 HalfEdgeDisplay::HalfEdgeDisplay(OpenGLContext* context)
-    : Drawable(context), representedHE(nullptr) {}
+    : Drawable(context), mesh(nullptr), representedHE(NO_INDEX) {}
 
-void HalfEdgeDisplay::updateHE(HalfEdge* he) {
+void HalfEdgeDisplay::updateHE(const HalfEdgeMesh* mesh, MeshIndex he) {
+    this->mesh = mesh;
     representedHE = he;
     initializeAndBufferGeometryData(); // rebuffer geometry data when half-edge is updated
 }
 
 void HalfEdgeDisplay::initializeAndBufferGeometryData() {
-    if (representedHE == nullptr) {
+    if (representedHE == NO_INDEX) {
         return;
     }
 
     std::vector<glm::vec3> pos(2); // two positions: start and end of the half-edge
 
-    pos[0] = representedHE->sym->vert->position;      // Start vertex position
-    pos[1] = representedHE->vert->position; // End vertex position (vertex HE is pointing to)
+    pos[0] = mesh->position(mesh->vert(mesh->sym(representedHE)));      // Start vertex position
+    pos[1] = mesh->position(mesh->vert(representedHE)); // End vertex position (vertex HE is pointing to)
     //change next to sym
 
     std::vector<unsigned int> indices = { 0, 1 };
@@ -176,15 +161,15 @@ void HalfEdgeDisplay::initializeAndBufferGeometryData() {
     // buffer vertex data
     generateBuffer(POSITION);
     bindBuffer(POSITION);
-    bufferData(POSITION, pos); // Two points
+    bufferData(POSITION, pos, GL_DYNAMIC_DRAW); // Two points
 
     generateBuffer(COLOR);
     bindBuffer(COLOR);
-    bufferData(COLOR, colors);
+    bufferData(COLOR, colors, GL_DYNAMIC_DRAW);
 
     generateBuffer(INDEX);
     bindBuffer(INDEX);
-    bufferData(INDEX, indices);
+    bufferData(INDEX, indices, GL_DYNAMIC_DRAW);
 }
 
 GLenum HalfEdgeDisplay::drawMode() {
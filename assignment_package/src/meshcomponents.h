@@ -3,73 +3,40 @@
 
 #include <glm/glm.hpp>
 #include "drawable.h"
-#include <QListWidgetItem>
+#include "core/halfedgemesh.h"
+#include <QAbstractListModel>
 #include <iostream>
 
-class HalfEdge;
-class Face;
-class Vertex;
-
-class Vertex : public QListWidgetItem {
-public:
-    glm::vec3 position;
-    HalfEdge* edge; //pointer to one of the HEs pointing to this Vert
-    int id; //unique int id for this Vert
-    bool isOriginal; // true for original vertices, false for newly created ones
-
-    Vertex(const glm::vec3& pos);
-
-    int getID() const; //getter for id
-    void setHE(HalfEdge* e);
-
-private:
-    static int nextID; //keep track of next avail id
-
-};
-
-class Face : public QListWidgetItem {
+// list model over one kind of element of a HalfEdgeMesh. Rows are the kernel's
+// indices and each label is made only when a view asks to show its row, so
+// listing a mesh costs nothing per element and a huge mesh lists as fast as a
+// cube. Views should set uniformItemSizes, or they measure every row up front.
+class MeshElementModel : public QAbstractListModel {
 public:
-    HalfEdge* edge; //one of the HEs that lie on this face
-    glm::vec3 color; //this face's color, rgb
-    int id; //unique int id for this face
-
-    Face(const glm::vec3& col);
-
-    int getID() const; //getter for id
-    void setEdge(HalfEdge* edge);
-
-private:
-    static int nextID; //keep track of next avail id
-
-};
+    enum Kind { Vertices, Faces, HalfEdges };
 
-class HalfEdge : public QListWidgetItem {
-public:
-    HalfEdge* next; //pointer to next HE in loop
-    HalfEdge* sym; //pointer to symmetric HE
-    Face* face; //pointer to face this HE lies in
-    Vertex* vert; //pointer to vert at end of this HE
-    int id; //unique int id for this HE
-    bool isOriginal; // true for original HEs, false for newly created ones
+    MeshElementModel(const HalfEdgeMesh* mesh, Kind kind, QObject* parent = nullptr);
 
-    HalfEdge();
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
 
-    int getID() const; //getter for id
-    void setNext(HalfEdge* nextEdge);
-    void setSym(HalfEdge* symEdge);
-    void setFace(Face* face);
-    void setVertex(Vertex* vert);
+    void elementsAdded(); //the kernel gained elements at the end, list them
+    void elementsReplaced(); //the kernel was replaced, every row may have changed
 
 private:
-    static int nextID; //keep track of next avail id
+    const HalfEdgeMesh* mesh; //kernel whose elements are listed
+    Kind kind;
+    int rows = 0; //what the views were last told, the kernel may have moved on
 
+    int kernelCount() const; //elements of our kind in the kernel
 };
 
 class VertexDisplay : public Drawable {
 public:
-    Vertex* representedVertex; //the vertex to be highlighted
+    const HalfEdgeMesh* mesh; //kernel the vertex lives in
+    MeshIndex representedVertex; //the vertex to be highlighted, NO_INDEX for none
     VertexDisplay(OpenGLContext* context); //inits opengl ontext from drawable
-    void updateVertex(Vertex* v); //update vertex currently being displayed
+    void updateVertex(const HalfEdgeMesh* mesh, MeshIndex v); //update vertex currently being displayed
     void initializeAndBufferGeometryData() override; //send vertex pos to GPU
     GLenum drawMode() override;
 
@@ -77,9 +44,10 @@ public:
 
 class FaceDisplay : public Drawable {
 public:
-    Face* representedFace; //the face to be highlighted
+    const HalfEdgeMesh* mesh; //kernel the face lives in
+    MeshIndex representedFace; //the face to be highlighted, NO_INDEX for none
     FaceDisplay(OpenGLContext* context); //inits opengl ontext from drawable
-    void updateFace(Face* f); //update face currently being displayed
+    void updateFace(const HalfEdgeMesh* mesh, MeshIndex f); //update face currently being displayed
     void initializeAndBufferGeometryData() override; //send face pos to GPU
     GLenum drawMode() override;
 
@@ -87,9 +55,10 @@ public:
 
 class HalfEdgeDisplay : public Drawable {
 public:
-    HalfEdge* representedHE; //the he to be highlighted
+    const HalfEdgeMesh* mesh; //kernel the he lives in
+    MeshIndex representedHE; //the he to be highlighted, NO_INDEX for none
     HalfEdgeDisplay(OpenGLContext* context); //inits opengl ontext from drawable
-    void updateHE(HalfEdge* he); //update vertex currently being displayed
+    void updateHE(const HalfEdgeMesh* mesh, MeshIndex he); //update vertex currently being displayed
     void initializeAndBufferGeometryData() override; //send vertex pos to GPU
     GLenum drawMode() override;
 
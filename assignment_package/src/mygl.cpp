@@ -8,10 +8,8 @@
 
 MyGL::MyGL(QWidget *parent)
     : OpenGLContext(parent),
-      timer(), currTime(0.),
       m_geomSquare(this),
-      m_progLambert(this), m_progFlat(this),
-      vao(),
+      m_progLambert(this), m_progFlat(this), m_progFaceFlat(this),
       m_camera(width(), height()),
       m_mousePosPrev(),
       my_mesh(this),
@@ -21,15 +19,13 @@ MyGL::MyGL(QWidget *parent)
 {
     setFocusPolicy(Qt::StrongFocus);
 
-    connect(&timer, SIGNAL(timeout()), this, SLOT(tick()));
-    // Tell the timer to redraw 60 times per second
-    timer.start(16);
+    // Frames are drawn on demand: whatever changes the view calls update(),
+    // and Qt folds every call made before the next paint into one paintGL.
 }
 
 MyGL::~MyGL()
 {
-    makeCurrent();
-    glDeleteVertexArrays(1, &vao);
+    makeCurrent(); // the drawables delete their buffers and VAOs as they go
 }
 
 void MyGL::initializeGL()
@@ -53,9 +49,6 @@ void MyGL::initializeGL()
 
     printGLErrorLog();
 
-    // Create a Vertex Attribute Object
-    glGenVertexArrays(1, &vao);
-
     //Create the instances of Cylinder and Sphere.
     m_geomSquare.initializeAndBufferGeometryData();
 
@@ -63,10 +56,11 @@ void MyGL::initializeGL()
     m_progLambert.createAndCompileShaderProgram("lambert.vert.glsl", "lambert.frag.glsl");
     // Create and set up the flat lighting shader
     m_progFlat.createAndCompileShaderProgram("flat.vert.glsl", "flat.frag.glsl");
+    // and its variant for meshes whose face colors live in buffer textures
+    m_progFaceFlat.createAndCompileShaderProgram("faceflat.vert.glsl", "faceflat.frag.glsl");
 
-    // We have to have a VAO bound in OpenGL 3.2 Core. But if we're not
-    // using multiple VAOs, we can just bind one once.
-    glBindVertexArray(vao);
+    // Every Drawable owns a VAO, which it binds before touching its index
+    // buffer or being drawn, so there's no global one to bind here.
 }
 
 void MyGL::resizeGL(int w, int h)
@@ -77,8 +71,9 @@ void MyGL::resizeGL(int w, int h)
 
     // Upload the view-projection matrix to our shaders (i.e. onto the graphics card)
     glm::mat4 viewproj = m_camera.getViewProj();
-    m_progLambert.setUnifMat4("u_ViewProj", viewproj);
-    m_progFlat.setUnifMat4("u_ViewProj", viewproj);
+    m_progLambert.setUniform(U_VIEW_PROJ, viewproj);
+    m_progFlat.setUniform(U_VIEW_PROJ, viewproj);
+    m_progFaceFlat.setUniform(U_VIEW_PROJ, viewproj);
 
     printGLErrorLog();
 }
@@ -91,10 +86,11 @@ void MyGL::paintGL()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     glm::mat4 viewproj = m_camera.getViewProj();
-    m_progLambert.setUnifMat4("u_ViewProj", viewproj);
-    m_progFlat.setUnifMat4("u_ViewProj", viewproj);
-    m_progLambert.setUnifVec3("u_CamPos", m_camera.eye);
-    m_progFlat.setUnifMat4("u_Model", glm::mat4(1.f));
+    m_progLambert.setUniform(U_VIEW_PROJ, viewproj);
+    m_progFlat.setUniform(U_VIEW_PROJ, viewproj);
+    m_progFaceFlat.setUniform(U_VIEW_PROJ, viewproj);
+    m_progLambert.setUniform(U_CAM_POS, m_camera.eye);
+    m_progFlat.setUniform(U_MODEL, glm::mat4(1.f));
 
     //Create a model matrix. This one rotates the square by PI/4 radians then translates it by <-2,0,0>.
     //Note that we have to transpose the model matrix before passing it to the shader
@@ -102,42 +98,48 @@ void MyGL::paintGL()
     //implemented row-major matrices.
     glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(-2,0,0)) * glm::rotate(glm::mat4(), 0.25f * 3.14159f, glm::vec3(0,1,0));
     //Send the geometry's transformation matrix to the shader
-    m_progLambert.setUnifMat4("u_Model", model);
-    m_progLambert.setUnifMat4("u_ModelInvTr", glm::inverse(glm::transpose(model)));
+    m_progLambert.setUniform(U_MODEL, model);
+    m_progLambert.setUniform(U_MODEL_INV_TR, glm::inverse(glm::transpose(model)));
     //Draw the example sphere using our lambert shader
     m_progLambert.draw(m_geomSquare);
     //Now do the same to render the cylinder
     //We've rotated it -45 degrees on the Z axis, then translated it to the point <2,2,0>
     model = glm::translate(glm::mat4(1.0f), glm::vec3(2,2,0)) * glm::rotate(glm::mat4(1.0f), glm::radians(-45.0f), glm::vec3(0,0,1));
-    m_progLambert.setUnifMat4("u_Model", model);
-    m_progLambert.setUnifMat4("u_ModelInvTr", glm::inverse(glm::transpose(model)));
+    m_progLambert.setUniform(U_MODEL, model);
+    m_progLambert.setUniform(U_MODEL_INV_TR, glm::inverse(glm::transpose(model)));
     m_progLambert.draw(m_geomSquare);
 
     model = glm::mat4(1);
     //Send the geometry's transformation matrix to the shader
-    m_progFlat.setUnifMat4("u_Model", model);
-    m_progLambert.setUnifMat4("u_ModelInvTr", glm::inverse(glm::transpose(model)));
+    m_progFlat.setUniform(U_MODEL, model);
+    m_progFaceFlat.setUniform(U_MODEL, model);
+    m_progLambert.setUniform(U_MODEL, model);
+    m_progLambert.setUniform(U_MODEL_INV_TR, glm::inverse(glm::transpose(model)));
     //Draw the example sphere using our lambert shader
     if (meshLoaded) {
         // Clear the screen so that we only see newly drawn images
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        m_progFlat.draw(my_mesh);
+        my_mesh.bufferEdits(); //vertex moves and face colours made since the last frame
+        Drawable& shown = my_mesh.shownDrawable();
+        // meshes are buffered from shared vertices and drawn flat, adaptive
+        // patches per vertex with their limit normals, so they're lit
+        (shown.hasBuffer(TRIANGLE_FACE) ? m_progFaceFlat : m_progLambert).draw(shown);
     }
 
     // draw selected mesh components
-    if (m_vertDisplay.representedVertex) {
+    if (m_vertDisplay.representedVertex != NO_INDEX) {
         glDisable(GL_DEPTH_TEST); // so vertex is drawn on top of the mesh
         m_progFlat.draw(m_vertDisplay);
         glEnable(GL_DEPTH_TEST);
     }
 
-    if (m_faceDisplay.representedFace) {
+    if (m_faceDisplay.representedFace != NO_INDEX) {
         glDisable(GL_DEPTH_TEST); // so face edges are drawn on top of the mesh
         m_progFlat.draw(m_faceDisplay);
         glEnable(GL_DEPTH_TEST);
     }
 
-    if (m_HEDisplay.representedHE) {
+    if (m_HEDisplay.representedHE != NO_INDEX) {
         glDisable(GL_DEPTH_TEST); // so HE is drawn on top of the mesh
         m_progFlat.draw(m_HEDisplay);
         glEnable(GL_DEPTH_TEST);
@@ -148,47 +150,139 @@ OpenGLContext* MyGL::getOpenGLContext() {
     return this; // return the current instance as OpenGLContext
 }
 
+void MyGL::setMesh(HalfEdgeMesh&& loaded) {
+    m_vertDisplay.representedVertex = NO_INDEX; //reset selected mesh components, they're from the old mesh
+    m_faceDisplay.representedFace = NO_INDEX;
+    m_HEDisplay.representedHE = NO_INDEX;
+
+    my_mesh.setKernel(std::move(loaded));
+
+    makeCurrent(); //buffer uploads need our GL context, which only lives on this thread
+    my_mesh.initializeAndBufferGeometryData();
+    doneCurrent();
+
+    meshLoaded = true; //set meshLoaded as true so PaintGL() will paint our mesh
+    update();
+}
+
+void MyGL::showLevel(int level) {
+    if (!meshLoaded) return;
+
+    makeCurrent(); //a level shown for the first time is uploaded into its own buffers
+    my_mesh.setShownLevel(level);
+    doneCurrent();
+    update();
+}
+
+void MyGL::releaseHiddenLevels() {
+    makeCurrent(); //the released levels' buffers are deleted
+    my_mesh.releaseHiddenLevels();
+    doneCurrent();
+    update();
+}
+
+void MyGL::setAdaptive(bool adaptive) {
+    makeCurrent(); //the shown level may be uploaded in its other form
+    my_mesh.setAdaptive(adaptive);
+    doneCurrent();
+    update();
+}
+
+void MyGL::setScheme(SubdivisionScheme scheme) {
+    makeCurrent(); //the shown level is refined again
+    my_mesh.setScheme(scheme);
+    doneCurrent();
+    update();
+}
+
+void MyGL::meshEdited() {
+    makeCurrent();
+    my_mesh.initializeAndBufferGeometryData();
+    m_vertDisplay.initializeAndBufferGeometryData();
+    m_faceDisplay.initializeAndBufferGeometryData();
+    m_HEDisplay.initializeAndBufferGeometryData();
+    doneCurrent();
+    update();
+}
+
+void MyGL::vertexMoved(MeshIndex v) {
+    my_mesh.vertexMoved(v); //uploaded with the next frame, however many spinboxes tick before it
+    makeCurrent();
+    m_vertDisplay.initializeAndBufferGeometryData();
+    doneCurrent();
+    update();
+}
+
+void MyGL::selectVertex(MeshIndex v) {
+    makeCurrent();
+    m_vertDisplay.updateVertex(&my_mesh.kernel(), v < my_mesh.kernel().numVertices() ? v : NO_INDEX);
+    doneCurrent();
+    update(); //the selection is drawn over the mesh
+}
+
+void MyGL::selectFace(MeshIndex f) {
+    makeCurrent();
+    m_faceDisplay.updateFace(&my_mesh.kernel(), f < my_mesh.kernel().numFaces() ? f : NO_INDEX);
+    doneCurrent();
+    update();
+}
+
+void MyGL::selectHalfEdge(MeshIndex he) {
+    makeCurrent();
+    m_HEDisplay.updateHE(&my_mesh.kernel(), he < my_mesh.kernel().numHalfEdges() ? he : NO_INDEX);
+    doneCurrent();
+    update();
+}
+
 void MyGL::keyPressEvent(QKeyEvent *e) {
+    const HalfEdgeMesh& mesh = my_mesh.kernel();
     switch (e->key()) {
         case Qt::Key_N: // NEXT he of the currently selected he
-            if (m_HEDisplay.representedHE != nullptr) {
-                    m_HEDisplay.updateHE(m_HEDisplay.representedHE->next);
+            if (m_HEDisplay.representedHE != NO_INDEX) {
+                selectHalfEdge(mesh.next(m_HEDisplay.representedHE));
             }
             break;
 
-        case Qt::Key_M: //  SYM he of the currently selected he *syms are not correct
-            if (m_HEDisplay.representedHE != nullptr) {
-                m_HEDisplay.updateHE(m_HEDisplay.representedHE->sym);
+        case Qt::Key_M: //  SYM he of the currently selected he
+            if (m_HEDisplay.representedHE != NO_INDEX) {
+                selectHalfEdge(mesh.sym(m_HEDisplay.representedHE));
             }
             break;
 
         case Qt::Key_F: //  FACE of the currently selected he
-            if (m_HEDisplay.representedHE != nullptr) {
-                m_faceDisplay.updateFace(m_HEDisplay.representedHE->face);
+            if (m_HEDisplay.representedHE != NO_INDEX) {
+                selectFace(mesh.face(m_HEDisplay.representedHE)); //NO_INDEX on boundary HEs, which selects nothing
             }
             break;
 
         case Qt::Key_V: // VERTEX of the currently selected he
-            if (m_HEDisplay.representedHE != nullptr) {
-                m_vertDisplay.updateVertex(m_HEDisplay.representedHE->vert);
+            if (m_HEDisplay.representedHE != NO_INDEX) {
+                selectVertex(mesh.vert(m_HEDisplay.representedHE));
             }
             break;
 
         case Qt::Key_H:
             if (e->modifiers() & Qt::ShiftModifier) {
                 // Select HE of the currently selected face
-                if (m_faceDisplay.representedFace != nullptr) {
-                    m_HEDisplay.updateHE(m_faceDisplay.representedFace->edge);
+                if (m_faceDisplay.representedFace != NO_INDEX) {
+                    selectHalfEdge(mesh.faceEdge(m_faceDisplay.representedFace));
                 }
                 break;
             }
             // HE of the currently selected vertex
-            if (m_vertDisplay.representedVertex != nullptr) {
-                m_HEDisplay.updateHE(m_vertDisplay.representedVertex->edge);
+            if (m_vertDisplay.representedVertex != NO_INDEX) {
+                selectHalfEdge(mesh.vertexEdge(m_vertDisplay.representedVertex));
             }
 
             break;
 
+        case Qt::Key_0: // show the cage, or its level 1-3 subdivision
+        case Qt::Key_1:
+        case Qt::Key_2:
+        case Qt::Key_3:
+            showLevel(e->key() - Qt::Key_0);
+            break;
+
         default:
             break;
     }
@@ -221,13 +315,14 @@ void MyGL::mouseMoveEvent(QMouseEvent *e) {
         m_camera.PanAlongRight(-diff.x);
         m_camera.PanAlongUp(diff.y);
     }
+    else
+    {
+        return; // hovering doesn't move the camera
+    }
+    update();
 }
 
 void MyGL::wheelEvent(QWheelEvent *e) {
     m_camera.Zoom(e->angleDelta().y() * 0.001f);
-}
-
-void MyGL::tick() {
-    ++currTime;
     update();
 }
@@ -11,7 +11,6 @@
 
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
-#include <QTimer>
 
 
 class MyGL
@@ -19,15 +18,10 @@ class MyGL
 {
     Q_OBJECT
 private:
-    QTimer timer;
-    float currTime;
-
     SquarePlane m_geomSquare;// The instance of a unit cylinder we can use to render any cylinder
     ShaderProgram m_progLambert;// A shader program that uses lambertian reflection
     ShaderProgram m_progFlat;// A shader program that uses "flat" reflection (no shadowing at all)
-
-    GLuint vao; // A handle for our vertex array object. This will store the VBOs created in our geometry classes.
-                // Don't worry too much about this. Just know it is necessary in order to render geometry.
+    ShaderProgram m_progFaceFlat;// Flat, with colors looked up per face for meshes buffered from shared vertices
 
     Camera m_camera;
     // A variable used to track the mouse's previous position when
@@ -46,6 +40,19 @@ public:
     OpenGLContext* getOpenGLContext();
     Mesh my_mesh; //my mesh!
     bool meshLoaded = false; //so the program doesn't crash on opening
+    void setMesh(HalfEdgeMesh&& loaded); //show a freshly loaded kernel, uploads it with our context current
+    void showLevel(int level); //show a subdivision level of the mesh, 0 is the cage
+    void releaseHiddenLevels();
+    void setAdaptive(bool adaptive); //draw levels as adaptive patches
+    void setScheme(SubdivisionScheme scheme);
+
+    //the mesh and the displays upload into our context, which Qt only makes
+    //current around paintGL and friends, so slots edit them through these
+    void meshEdited(); //re-upload the mesh and the selection after a topology change
+    void vertexMoved(MeshIndex v);
+    void selectVertex(MeshIndex v); //NO_INDEX, or any index past the kernel's, selects nothing
+    void selectFace(MeshIndex f);
+    void selectHalfEdge(MeshIndex he);
 
     VertexDisplay m_vertDisplay;
     FaceDisplay m_faceDisplay;
@@ -57,9 +64,6 @@ protected:
     void mouseMoveEvent(QMouseEvent *e);
     void wheelEvent(QWheelEvent *e);
 
-public slots:
-    void tick();
-
 };
 
 
@@ -1,45 +1,48 @@
 #include "shaderprogram.h"
 #include "utils.h"
+#include <algorithm>
 #include <iostream>
+#include <cstring>
 
 ShaderProgram::ShaderProgram(OpenGLContext *context)
-    : glContext(context)
-{}
+    : glContext(context),
+      uniformLocations(),
+      sentUniforms()
+{
+    uniformLocations.fill(-1);
+}
+
+const char *uniformName(Uniform u) {
+    static const char *const names[NUM_UNIFORMS] = {
+        "u_Model", "u_ModelInvTr", "u_ViewProj", "u_CamPos",
+        "u_Dequantize", "u_OctNormals",
+        "u_FaceColors", "u_TriangleFaces"
+    };
+    return names[u];
+}
 
 void ShaderProgram::draw(Drawable &d) {
     useProgram();
-    if(isAttribHandleValid("vs_Pos")) {
-        d.bindBuffer(POSITION);
-        glContext->glEnableVertexAttribArray(getAttribHandle("vs_Pos"));
-        glContext->glVertexAttribPointer(getAttribHandle("vs_Pos"), 3, GL_FLOAT, false, 0, nullptr);
+    setUniform(U_DEQUANTIZE, d.getPositionDequantization());
+    if(hasUniform(U_OCT_NORMALS)) {
+        const std::vector<VertexAttribute> &layout = d.getVertexLayout();
+        bool oct = std::any_of(layout.begin(), layout.end(),
+                               [](const VertexAttribute &a) { return a.attrib == VS_OCT_NOR; });
+        setUniform(U_OCT_NORMALS, oct ? 1 : 0);
     }
-    printGLErrorLog();
-    if(isAttribHandleValid("vs_Nor")) {
-        d.bindBuffer(NORMAL);
-        glContext->glEnableVertexAttribArray(getAttribHandle("vs_Nor"));
-        glContext->glVertexAttribPointer(getAttribHandle("vs_Nor"), 3, GL_FLOAT, false, 0, nullptr);
+    // Per-face data is looked up by the fragment shader from buffer textures
+    if(hasUniform(U_FACE_COLORS) && d.hasBuffer(FACE_COLOR)) {
+        d.bindTexture(FACE_COLOR, 0);
+        setUniform(U_FACE_COLORS, 0);
     }
-    printGLErrorLog();
-    if(isAttribHandleValid("vs_Col")) {
-        d.bindBuffer(COLOR);
-        glContext->glEnableVertexAttribArray(getAttribHandle("vs_Col"));
-        glContext->glVertexAttribPointer(getAttribHandle("vs_Col"), 3, GL_FLOAT, false, 0, nullptr);
+    if(hasUniform(U_TRIANGLE_FACES) && d.hasBuffer(TRIANGLE_FACE)) {
+        d.bindTexture(TRIANGLE_FACE, 1);
+        setUniform(U_TRIANGLE_FACES, 1);
     }
 
-    printGLErrorLog();
-    d.bindBuffer(INDEX);
+    // The drawable's VAO holds its attribute bindings and index buffer
+    d.bindVertexArray();
     glContext->glDrawElements(d.drawMode(), d.getIndexBufferLength(), GL_UNSIGNED_INT, 0);
-
-    printGLErrorLog();
-    if(isAttribHandleValid("vs_Pos")) {
-        glContext->glDisableVertexAttribArray(getAttribHandle("vs_Pos"));
-    }
-    if(isAttribHandleValid("vs_Nor")) {
-        glContext->glDisableVertexAttribArray(getAttribHandle("vs_Nor"));
-    }
-    if(isAttribHandleValid("vs_Col")) {
-        glContext->glDisableVertexAttribArray(getAttribHandle("vs_Col"));
-    }
     printGLErrorLog();
 }
 
@@ -119,6 +122,11 @@ void ShaderProgram::createAndCompileShaderProgram(QString vertFile,
     // these particular vertex and fragment shaders
     glContext->glAttachShader(shaderProgram, vertShader);
     glContext->glAttachShader(shaderProgram, fragShader);
+    // Fix where every attribute a drawable may supply is read from, so one
+    // VAO per drawable serves every program
+    for(GLuint a = 0; a < NUM_VERTEX_ATTRIBS; ++a) {
+        glContext->glBindAttribLocation(shaderProgram, a, vertexAttribName(static_cast<VertexAttrib>(a)));
+    }
     glContext->glLinkProgram(shaderProgram);
 
     // Check for linking success
@@ -129,6 +137,10 @@ void ShaderProgram::createAndCompileShaderProgram(QString vertFile,
     }
 
     parseShaderSourceForVariables(vertexShaderSource, fragmentShaderSource);
+    for(int u = 0; u < NUM_UNIFORMS; ++u) {
+        uniformLocations[u] = glContext->glGetUniformLocation(shaderProgram, uniformName(static_cast<Uniform>(u)));
+        sentUniforms[u].valid = false;
+    }
     // Manually de-allocate the heap memory used to store the
     // shader contents. We don't need it now that it's been sent
     // to the GPU.
@@ -238,52 +250,107 @@ bool ShaderProgram::isAttribHandleValid(std::string name) const {
     }
 }
 
+bool ShaderProgram::hasUniform(Uniform u) const {
+    return uniformLocations[u] != -1;
+}
+
+bool ShaderProgram::changesUniform(Uniform u, const void *val, std::size_t size) {
+    if(uniformLocations[u] == -1) {
+        return false;
+    }
+    SentUniform &sent = sentUniforms[u];
+    if(sent.valid && std::memcmp(sent.bytes.data(), val, size) == 0) {
+        return false;
+    }
+    std::memcpy(sent.bytes.data(), val, size);
+    sent.valid = true;
+    return true;
+}
+
+void ShaderProgram::forgetUniform(const std::string &name) {
+    for(int u = 0; u < NUM_UNIFORMS; ++u) {
+        if(name == uniformName(static_cast<Uniform>(u))) {
+            sentUniforms[u].valid = false;
+        }
+    }
+}
+
+void ShaderProgram::setUniform(Uniform u, int val) {
+    if(changesUniform(u, &val, sizeof(val))) {
+        useProgram();
+        glContext->glUniform1i(uniformLocations[u], val);
+    }
+}
+void ShaderProgram::setUniform(Uniform u, const glm::vec3 &val) {
+    if(changesUniform(u, &val, sizeof(val))) {
+        useProgram();
+        glContext->glUniform3fv(uniformLocations[u], 1, &val[0]);
+    }
+}
+void ShaderProgram::setUniform(Uniform u, const glm::mat4 &val) {
+    if(changesUniform(u, &val, sizeof(val))) {
+        useProgram();
+        glContext->glUniformMatrix4fv(uniformLocations[u], 1, GL_FALSE, &val[0][0]);
+    }
+}
+
 void ShaderProgram::setUnifInt(std::string name, int val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform1i(getUniformHandle(name), val);
 }
 void ShaderProgram::setUnifFloat(std::string name, float val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform1f(getUniformHandle(name), val);
 }
 void ShaderProgram::setUnifVec2(std::string name, glm::vec2 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform2fv(getUniformHandle(name), 1, &val[0]);
 }
 void ShaderProgram::setUnifVec3(std::string name, glm::vec3 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform3fv(getUniformHandle(name), 1, &val[0]);
 }
 void ShaderProgram::setUnifVec4(std::string name, glm::vec4 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform4fv(getUniformHandle(name), 1, &val[0]);
 }
 
 void ShaderProgram::setUnifIVec2(std::string name, glm::ivec2 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform2iv(getUniformHandle(name), 1, &val[0]);
 }
 void ShaderProgram::setUnifIVec3(std::string name, glm::ivec3 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform3iv(getUniformHandle(name), 1, &val[0]);
 }
 void ShaderProgram::setUnifIVec4(std::string name, glm::ivec4 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniform4iv(getUniformHandle(name), 1, &val[0]);
 }
 
 void ShaderProgram::setUnifMat2(std::string name, glm::mat2 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniformMatrix2fv(getUniformHandle(name), 1,
                                   GL_FALSE, &val[0][0]);
 }
 void ShaderProgram::setUnifMat3(std::string name, glm::mat3 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniformMatrix3fv(getUniformHandle(name), 1,
                                   GL_FALSE, &val[0][0]);
 }
 void ShaderProgram::setUnifMat4(std::string name, glm::mat4 val) {
     useProgram();
+    forgetUniform(name);
     glContext->glUniformMatrix4fv(getUniformHandle(name), 1,
                                   GL_FALSE, &val[0][0]);
 }
@@ -2,6 +2,17 @@
 #include <openglcontext.h>
 #include "drawable.h"
 #include <la.h>
+#include <array>
+
+// The uniforms the shaders declare, each resolved to a location once per
+// program so setting one never looks up its name.
+enum Uniform {
+    U_MODEL, U_MODEL_INV_TR, U_VIEW_PROJ, U_CAM_POS,
+    U_DEQUANTIZE, U_OCT_NORMALS,
+    U_FACE_COLORS, U_TRIANGLE_FACES,
+    NUM_UNIFORMS
+};
+const char *uniformName(Uniform u); // as written in the shaders, e.g. u_ViewProj
 
 class ShaderProgram {
 private:
@@ -27,6 +38,18 @@ private:
     std::unordered_map<std::string, GLint> shaderUniformVariableHandles;
     void parseShaderSourceForVariables(char *vertSource, char *fragSource);
 
+    // Locations of the Uniform slots, -1 for those this program doesn't
+    // use, and the value last sent to each, so that sending the same value
+    // again costs a compare instead of a GL call.
+    struct SentUniform {
+        std::array<unsigned char, sizeof(glm::mat4)> bytes;
+        bool valid = false;
+    };
+    std::array<GLint, NUM_UNIFORMS> uniformLocations;
+    std::array<SentUniform, NUM_UNIFORMS> sentUniforms;
+    bool changesUniform(Uniform u, const void *val, std::size_t size);
+    void forgetUniform(const std::string &name); // a string setter sent it behind the cache's back
+
 
     // Prints any error messages from the shader program linking
     // process to the console.
@@ -64,6 +87,13 @@ public:
     void addUniform(std::string name);
     void addAttrib(std::string name);
 
+    // Typed setters for the Uniform slots. Values equal to the ones last
+    // sent are skipped, as are slots the program doesn't use.
+    bool hasUniform(Uniform u) const;
+    void setUniform(Uniform u, int val);
+    void setUniform(Uniform u, const glm::vec3 &val);
+    void setUniform(Uniform u, const glm::mat4 &val);
+
     void setUnifInt(std::string name, int val);
     void setUnifFloat(std::string name, float val);
 
@@ -13,7 +13,21 @@ SOURCES += \
     $$PWD/drawable.cpp \
     $$PWD/camera.cpp \
     $$PWD/openglcontext.cpp \
-    $$PWD/scene/squareplane.cpp
+    $$PWD/scene/squareplane.cpp \
+    $$PWD/surfacedrawable.cpp \
+    $$PWD/core/adaptivesurface.cpp \
+    $$PWD/core/bsplinepatch.cpp \
+    $$PWD/core/catmullclark.cpp \
+    $$PWD/core/halfedgemesh.cpp \
+    $$PWD/core/hedsformat.cpp \
+    $$PWD/core/limitevaluator.cpp \
+    $$PWD/core/loopsubdivision.cpp \
+    $$PWD/core/mappedfile.cpp \
+    $$PWD/core/objparser.cpp \
+    $$PWD/core/radixsort.cpp \
+    $$PWD/core/stenciltable.cpp \
+    $$PWD/core/streamingsubdivision.cpp \
+    $$PWD/core/subdivisionhierarchy.cpp
 
 HEADERS += \
     $$PWD/la.h \
@@ -26,7 +40,24 @@ HEADERS += \
     $$PWD/drawable.h \
     $$PWD/camera.h \
     $$PWD/openglcontext.h \
-    $$PWD/scene/squareplane.h
+    $$PWD/scene/squareplane.h \
+    $$PWD/surfacedrawable.h \
+    $$PWD/core/adaptivesurface.h \
+    $$PWD/core/bsplinepatch.h \
+    $$PWD/core/catmullclark.h \
+    $$PWD/core/circulators.h \
+    $$PWD/core/halfedgemesh.h \
+    $$PWD/core/hedsformat.h \
+    $$PWD/core/limitevaluator.h \
+    $$PWD/core/loadprogress.h \
+    $$PWD/core/loopsubdivision.h \
+    $$PWD/core/mappedfile.h \
+    $$PWD/core/objparser.h \
+    $$PWD/core/parallel.h \
+    $$PWD/core/radixsort.h \
+    $$PWD/core/stenciltable.h \
+    $$PWD/core/streamingsubdivision.h \
+    $$PWD/core/subdivisionhierarchy.h
 
 DISTFILES += \
     $$PWD/README
@@ -0,0 +1,269 @@
+#include "surfacedrawable.h"
+#include "core/circulators.h"
+#include "core/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+//one vert of the Interleaved and Quantized formats. Every attribute starts on
+//a multiple of its own size
+struct InterleavedVertex {
+    GLfloat position[3];
+    GLubyte color[4];
+    GLbyte normal[2]; //octahedral
+    GLubyte padding[2];
+};
+struct QuantizedVertex {
+    GLushort position[3]; //[0, 65535] over the bounding box, u_Dequantize maps them back
+    GLbyte normal[2]; //octahedral
+    GLubyte color[4];
+};
+static_assert(sizeof(InterleavedVertex) == 20 && sizeof(QuantizedVertex) == 12, "vertex formats are packed");
+
+//a colour as an RGBA8 texel or attribute, which faceflat.frag.glsl and vs_Col read
+static void packColor(const glm::vec3& color, GLubyte* texel) {
+    const glm::vec3 scaled = glm::clamp(color, 0.f, 1.f) * 255.f + 0.5f;
+    for (int c = 0; c < 3; ++c) {
+        texel[c] = static_cast<GLubyte>(scaled[c]);
+    }
+    texel[3] = 255;
+}
+
+//a unit normal projected onto the octahedron |x| + |y| + |z| = 1, its lower half
+//folded out over the corners of the square [-1, 1]^2, stored as two snorm8s.
+//Decodes to within about a degree of the original
+static void packOctahedralNormal(const glm::vec3& n, GLbyte* out) {
+    const float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    glm::vec2 p = sum > 0.f ? glm::vec2(n.x, n.y) / sum : glm::vec2(0.f);
+    if (n.z < 0.f) {
+        p = (1.f - glm::abs(glm::vec2(p.y, p.x))) * glm::vec2(p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f);
+    }
+    for (int c = 0; c < 2; ++c) {
+        out[c] = static_cast<GLbyte>(std::round(glm::clamp(p[c], -1.f, 1.f) * 127.f));
+    }
+}
+
+SurfaceDrawable::SurfaceDrawable(OpenGLContext* context, const HalfEdgeMesh* surface)
+    : Drawable(context), surface(surface) {}
+
+GLenum SurfaceDrawable::drawMode() {
+    return GL_TRIANGLES;
+}
+
+void SurfaceDrawable::setVertexFormat(VertexFormat format) {
+    vertexFormat = format;
+}
+
+void SurfaceDrawable::setSurface(const HalfEdgeMesh* surface) {
+    this->surface = surface;
+    patches = nullptr;
+}
+
+void SurfaceDrawable::setSurface(const AdaptiveSurface* patches) {
+    this->patches = patches;
+    surface = nullptr;
+}
+
+//implement drawable's initAndBufferGeomData
+void SurfaceDrawable::initializeAndBufferGeometryData() {
+    if (surface == nullptr && patches == nullptr) return;
+
+    if (patches) {
+        releaseBuffer(TRIANGLE_FACE); //left by an upload of a mesh
+        releaseBuffer(FACE_COLOR);
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec3> colors;
+        std::vector<unsigned int> indices;
+        patches->tessellate(positions, normals, colors, indices);
+        if (vertexFormat == VertexFormat::Separate) {
+            bufferTriangles(positions, normals, colors, indices);
+        } else {
+            bufferInterleaved(positions, normals, colors, indices);
+        }
+        return;
+    }
+
+    bufferFaces(*surface);
+}
+
+//positions go up straight from the kernel, one per vert, and every face is a fan
+//over its verts' ids. Each triangle's face and each face's color are buffer
+//textures the fragment shader reads through gl_PrimitiveID
+void SurfaceDrawable::bufferFaces(const HalfEdgeMesh& mesh) {
+    std::vector<GLuint> indices;
+    std::vector<GLuint> triangleFaces;
+    std::vector<GLubyte> faceColors(4 * static_cast<std::size_t>(mesh.numFaces()));
+    //a face of n sides has n - 2 triangles; the boundary HEs make this an overestimate
+    const std::size_t maxTriangles = mesh.numHalfEdges() - std::min(mesh.numHalfEdges(), 2 * mesh.numFaces());
+    indices.reserve(3 * maxTriangles);
+    triangleFaces.reserve(maxTriangles);
+
+    for (MeshIndex f = 0; f < mesh.numFaces(); ++f) {
+        FaceVertices corners = faceVertices(mesh, f);
+        auto it = corners.begin();
+        const MeshIndex first = *it;
+        MeshIndex prev = *++it;
+        for (++it; it != corners.end(); ++it) {
+            indices.push_back(first);
+            indices.push_back(prev);
+            indices.push_back(*it);
+            triangleFaces.push_back(f);
+            prev = *it;
+        }
+        packColor(mesh.faceColor(f), &faceColors[4 * static_cast<std::size_t>(f)]);
+    }
+
+    indexBufferLength = indices.size();
+    releaseBuffer(NORMAL); //left by an upload of patches
+    releaseBuffer(COLOR);
+    releaseBuffer(VERTEX);
+    setVertexLayout({{VS_POS, POSITION, 3, GL_FLOAT, false, 0, 0}});
+    positionDequantization = glm::mat4(1.f);
+
+    //positions and colours are patched in place by updatePositions/updateFaceColors
+    generateBuffer(POSITION);
+    bindBuffer(POSITION);
+    bufferData(POSITION, mesh.positionData(), mesh.numVertices(), GL_DYNAMIC_DRAW);
+
+    generateBuffer(INDEX);
+    bindBuffer(INDEX);
+    bufferData(INDEX, indices);
+
+    generateBuffer(TRIANGLE_FACE);
+    bindBuffer(TRIANGLE_FACE);
+    bufferData(TRIANGLE_FACE, triangleFaces);
+    bufferTexture(TRIANGLE_FACE, GL_R32UI);
+
+    generateBuffer(FACE_COLOR);
+    bindBuffer(FACE_COLOR);
+    bufferData(FACE_COLOR, faceColors, GL_DYNAMIC_DRAW);
+    bufferTexture(FACE_COLOR, GL_RGBA8);
+}
+
+//positions are shared per vert, so a moved vert is one element of POSITION; the
+//faces around it pick it up through the index buffer
+void SurfaceDrawable::updatePositions(MeshIndex begin, MeshIndex end) {
+    if (surface == nullptr || begin >= end || !hasBuffer(POSITION)) return;
+    bindBuffer(POSITION);
+    bufferSubData(POSITION, begin, surface->positionData() + begin, end - begin);
+}
+
+void SurfaceDrawable::updateFaceColors(MeshIndex begin, MeshIndex end) {
+    if (surface == nullptr || begin >= end || !hasBuffer(FACE_COLOR)) return;
+    std::vector<GLubyte> texels(4 * static_cast<std::size_t>(end - begin));
+    for (MeshIndex f = begin; f < end; ++f) {
+        packColor(surface->faceColor(f), &texels[4 * static_cast<std::size_t>(f - begin)]);
+    }
+    bindBuffer(FACE_COLOR);
+    bufferSubData(FACE_COLOR, 4 * static_cast<std::size_t>(begin), texels.data(), texels.size());
+}
+
+void SurfaceDrawable::bufferTriangles(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                                      const std::vector<glm::vec3>& colors, const std::vector<unsigned int>& indices) {
+    indexBufferLength = indices.size();
+    releaseBuffer(VERTEX); //left by an interleaved upload
+    setVertexLayout(separateLayout());
+    positionDequantization = glm::mat4(1.f);
+
+    // setup the VBOs with the data
+    setupVBOs();
+
+    bindBuffer(POSITION);
+    bufferData(POSITION, positions);
+
+    bindBuffer(NORMAL);
+    bufferData(NORMAL, normals);
+
+    bindBuffer(COLOR);
+    bufferData(COLOR, colors);
+
+    bindBuffer(INDEX);
+    bufferData(INDEX, indices);
+}
+
+//every vert's attributes side by side in one VERTEX buffer, so a vert is one
+//fetch, with its normal octahedral and its colour RGBA8. Quantized positions are
+//16-bit fractions of the bounding box, and positionDequantization scales and
+//offsets them back
+void SurfaceDrawable::bufferInterleaved(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                                        const std::vector<glm::vec3>& colors, const std::vector<unsigned int>& indices) {
+    indexBufferLength = indices.size();
+    releaseBuffer(POSITION); //left by a separate upload
+    releaseBuffer(NORMAL);
+    releaseBuffer(COLOR);
+    const std::size_t numVerts = positions.size();
+
+    generateBuffer(VERTEX);
+    bindBuffer(VERTEX);
+    if (vertexFormat == VertexFormat::Interleaved) {
+        std::vector<InterleavedVertex> verts(numVerts);
+        parallelFor(0, numVerts, 4096, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                for (int c = 0; c < 3; ++c) {
+                    verts[i].position[c] = positions[i][c];
+                }
+                packColor(colors[i], verts[i].color);
+                packOctahedralNormal(normals[i], verts[i].normal);
+                verts[i].padding[0] = verts[i].padding[1] = 0;
+            }
+        });
+        bufferData(VERTEX, verts);
+
+        const GLsizei stride = sizeof(InterleavedVertex);
+        setVertexLayout({
+            {VS_POS, VERTEX, 3, GL_FLOAT, false, stride, offsetof(InterleavedVertex, position)},
+            {VS_COL, VERTEX, 4, GL_UNSIGNED_BYTE, true, stride, offsetof(InterleavedVertex, color)},
+            {VS_OCT_NOR, VERTEX, 2, GL_BYTE, true, stride, offsetof(InterleavedVertex, normal)},
+        });
+        positionDequantization = glm::mat4(1.f);
+    } else {
+        glm::vec3 lo(0.f), hi(0.f);
+        if (numVerts > 0) {
+            lo = hi = positions[0];
+            for (const glm::vec3& p : positions) {
+                lo = glm::min(lo, p);
+                hi = glm::max(hi, p);
+            }
+        }
+        const glm::vec3 extent = hi - lo;
+        glm::vec3 toUnit(0.f); //a flat box keeps 0 across its thin axis
+        for (int c = 0; c < 3; ++c) {
+            if (extent[c] > 0.f) toUnit[c] = 65535.f / extent[c];
+        }
+
+        std::vector<QuantizedVertex> verts(numVerts);
+        parallelFor(0, numVerts, 4096, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const glm::vec3 q = glm::clamp((positions[i] - lo) * toUnit + 0.5f, 0.f, 65535.f);
+                for (int c = 0; c < 3; ++c) {
+                    verts[i].position[c] = static_cast<GLushort>(q[c]);
+                }
+                packOctahedralNormal(normals[i], verts[i].normal);
+                packColor(colors[i], verts[i].color);
+            }
+        });
+        bufferData(VERTEX, verts);
+
+        const GLsizei stride = sizeof(QuantizedVertex);
+        setVertexLayout({
+            {VS_POS, VERTEX, 3, GL_UNSIGNED_SHORT, true, stride, offsetof(QuantizedVertex, position)},
+            {VS_OCT_NOR, VERTEX, 2, GL_BYTE, true, stride, offsetof(QuantizedVertex, normal)},
+            {VS_COL, VERTEX, 4, GL_UNSIGNED_BYTE, true, stride, offsetof(QuantizedVertex, color)},
+        });
+        positionDequantization = glm::scale(glm::translate(glm::mat4(1.f), lo), extent);
+    }
+
+    generateBuffer(INDEX);
+    bindBuffer(INDEX);
+    bufferData(INDEX, indices);
+}
+
+//setup VBOs
+void SurfaceDrawable::setupVBOs() {
+    generateBuffer(POSITION);
+    generateBuffer(NORMAL);
+    generateBuffer(COLOR);
+    generateBuffer(INDEX);
+}
@@ -0,0 +1,60 @@
+#ifndef SURFACEDRAWABLE_H
+#define SURFACEDRAWABLE_H
+
+#include "drawable.h"
+#include "core/adaptivesurface.h"
+#include "core/halfedgemesh.h"
+
+// Draws a HalfEdgeMesh as flat-shaded triangles, every face as a fan with its
+// own colour, or an AdaptiveSurface tessellated into triangles that lambert
+// shades smoothly with the patches' normals.
+// The surface is only read while buffering, so it may be swapped for another
+// between uploads.
+//
+// A HalfEdgeMesh is buffered indexed: one position per vert, shared by every
+// face around it, and the faces' colours in FACE_COLOR/TRIANGLE_FACE buffer
+// textures, which faceflat.frag.glsl reads. A quad mesh costs 12 bytes per vert
+// plus 36 per face, against 144 + 24 per face when every corner carried its own
+// position, normal and colour. No normals are buffered for it: the flat shader
+// doesn't light, and a face's normal is the cross product of its position's
+// screen-space derivatives for one that does. Patches keep per-vertex
+// attributes, since their normals are smooth, in one of the VertexFormats.
+class SurfaceDrawable : public Drawable {
+public:
+    //how patches' per-vertex attributes are buffered. The packed formats hand
+    //their normals to vs_OctNor, which lambert.vert.glsl unfolds
+    enum class VertexFormat {
+        Separate,    //float vec3 POSITION, NORMAL and COLOR buffers, 36 bytes a vert
+        Interleaved, //one VERTEX buffer of float positions, RGBA8 colours and octahedral normals, 20 bytes
+        Quantized    //as Interleaved, with 16-bit positions over the patches' bounding box, 12 bytes
+    };
+
+    SurfaceDrawable(OpenGLContext* context, const HalfEdgeMesh* surface = nullptr);
+
+    void setVertexFormat(VertexFormat format); //used from the next upload on
+
+    void setSurface(const HalfEdgeMesh* surface); //mesh the next upload reads
+    void setSurface(const AdaptiveSurface* patches); //patches the next upload tessellates
+    void initializeAndBufferGeometryData() override;
+    GLenum drawMode() override;
+
+    //patch the buffers of a HalfEdgeMesh upload after its positions of verts, or
+    //colours of faces, in [begin, end) changed. Its topology must be the one
+    //last buffered
+    void updatePositions(MeshIndex begin, MeshIndex end);
+    void updateFaceColors(MeshIndex begin, MeshIndex end);
+
+private:
+    const HalfEdgeMesh* surface;
+    const AdaptiveSurface* patches = nullptr; //drawn instead of surface when set
+    VertexFormat vertexFormat = VertexFormat::Quantized;
+
+    void setupVBOs();
+    void bufferFaces(const HalfEdgeMesh& mesh);
+    void bufferTriangles(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                         const std::vector<glm::vec3>& colors, const std::vector<unsigned int>& indices);
+    void bufferInterleaved(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+                           const std::vector<glm::vec3>& colors, const std::vector<unsigned int>& indices);
+};
+
+#endif // SURFACEDRAWABLE_H